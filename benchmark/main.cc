@@ -0,0 +1,342 @@
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "cereal/archives/binary.hpp"
+
+#include "address-typeahead/extract_report.h"
+#include "address-typeahead/extractor.h"
+#include "address-typeahead/reverse_geocoder.h"
+#include "address-typeahead/score_kernels.h"
+#include "address-typeahead/serialization.h"
+#include "address-typeahead/typeahead.h"
+
+using namespace address_typeahead;
+
+double file_size_mb(std::string const& path) {
+  std::ifstream in(path, std::ios::binary | std::ios::ate);
+  return static_cast<double>(in.tellg()) / (1024.0 * 1024.0);
+}
+
+extract_options default_options() {
+  extract_options options;
+  options.whitelist_add("name");
+  options.whitelist_add("highway");
+  options.whitelist_add("addr:street");
+  options.whitelist_add("addr:housenumber");
+  options.blacklist_add("railway");
+  options.blacklist_add("highway", "service");
+  options.blacklist_add("highway", "bus_stop");
+  return options;
+}
+
+// runs the extraction once per location index type and compares the
+// throughput of the pass resolving node locations
+void benchmark_location_index(std::string const& input_path,
+                              std::string const& index_path) {
+  auto const input_mb = file_size_mb(input_path);
+  auto const types = std::vector<location_index_type>{
+      location_index_type::FLEX_MEM, location_index_type::SPARSE_MEM,
+#ifdef __linux__
+      location_index_type::DENSE_MMAP,
+#endif
+      location_index_type::DENSE_FILE, location_index_type::SPARSE_FILE};
+
+  std::cout << std::setw(12) << "index" << std::setw(12) << "pass [s]"
+            << std::setw(12) << "MB/s" << std::setw(12) << "total [s]"
+            << std::setw(16) << "peak rss [MB]\n";
+  for (auto const type : types) {
+    auto options = default_options();
+    options.location_index_ = type;
+    options.location_index_path_ = index_path;
+
+    extract_report report;
+    report.reset_peak_rss_ = true;
+    extract(input_path, options, report);
+
+    auto pass_s = 0.0;
+    auto total_s = 0.0;
+    auto peak_rss = uint64_t(0);
+    for (auto const& stage : report.stages_) {
+      if (stage.name_ == "node_locations_and_areas") {
+        pass_s = stage.wall_time_s_;
+        peak_rss = stage.peak_rss_bytes_;
+      }
+      total_s += stage.wall_time_s_;
+    }
+    std::cout << std::setw(12) << to_str(type) << std::setw(12) << pass_s
+              << std::setw(12) << input_mb / pass_s << std::setw(12)
+              << total_s << std::setw(15)
+              << static_cast<double>(peak_rss) / (1024.0 * 1024.0) << "\n";
+  }
+}
+
+// one query per line (whitespace separated strings), without a query file
+// every n-th name is used with its last character missing (as typed)
+std::vector<std::vector<std::string>> load_queries(
+    std::string const& path, typeahead_context const& context) {
+  auto queries = std::vector<std::vector<std::string>>();
+  if (!path.empty()) {
+    std::ifstream in(path);
+    std::string line;
+    while (std::getline(in, line)) {
+      auto ss = std::stringstream(line);
+      auto query = std::vector<std::string>();
+      auto str = std::string();
+      while (ss >> str) {
+        query.emplace_back(str);
+      }
+      if (!query.empty()) {
+        queries.emplace_back(query);
+      }
+    }
+    return queries;
+  }
+
+  auto const step = std::max(size_t(1), context.names_.size() / 1000);
+  for (auto i = size_t(0); i < context.names_.size(); i += step) {
+    auto const& name = context.names_[i];
+    queries.push_back({name.substr(0, std::max(size_t(3), name.size() - 1))});
+  }
+  return queries;
+}
+
+struct latency {
+  template <typename Fn>
+  void measure(Fn&& fn) {
+    auto const start = std::chrono::steady_clock::now();
+    fn();
+    auto const stop = std::chrono::steady_clock::now();
+    us_.push_back(
+        std::chrono::duration<double, std::micro>(stop - start).count());
+  }
+
+  double mean() const {
+    auto sum = 0.0;
+    for (auto const us : us_) {
+      sum += us;
+    }
+    return us_.empty() ? 0.0 : sum / static_cast<double>(us_.size());
+  }
+
+  double p99() {
+    if (us_.empty()) {
+      return 0.0;
+    }
+    std::sort(begin(us_), end(us_));
+    return us_[us_.size() * 99 / 100];
+  }
+
+  std::vector<double> us_;
+};
+
+// builds the typeahead with every match engine and compares build time,
+// memory, candidate generation and complete() latency on the same queries,
+// then once more with a hot tier (default size, by static importance)
+void benchmark_engines(std::string const& context_path,
+                       std::string const& query_path) {
+  typeahead_context context;
+  {
+    std::ifstream in(context_path, std::ios::binary);
+    in.exceptions(std::ios_base::failbit);
+    cereal::BinaryInputArchive ia(in);
+    ia(context);
+  }
+  auto const queries = load_queries(query_path, context);
+  std::cout << queries.size() << " queries\n";
+
+  auto options = complete_options();
+  options.string_chain_len_ = 2;
+
+  auto reference = std::vector<std::vector<index_t>>();
+  std::cout << std::setw(8) << "engine" << std::setw(12) << "build [s]"
+            << std::setw(16) << "peak rss [MB]" << std::setw(14)
+            << "index [MB]" << std::setw(12) << "heap [MB]" << std::setw(14)
+            << "guess [us]" << std::setw(14) << "guess p99" << std::setw(16)
+            << "complete [us]" << std::setw(14) << "complete p99"
+            << std::setw(12) << "same top" << std::setw(12) << "hot [us]"
+            << std::setw(12) << "hot p99" << std::setw(12) << "hot hits\n";
+  for (auto const engine : {match_engine::GUESS, match_engine::NGRAM}) {
+    extract_report report;
+    report.reset_peak_rss_ = true;
+    report.start_stage("build");
+    auto t = typeahead(context, engine);
+    report.finish_stage();
+
+    auto guess = latency();
+    auto complete = latency();
+    auto same_top = size_t(0);
+    for (auto i = size_t(0); i != queries.size(); ++i) {
+      auto const& query = queries[i];
+      guess.measure([&]() {
+        if (engine == match_engine::GUESS) {
+          t.place_guesser_.guess_match(query[0], options.max_guesses_);
+        } else {
+          t.place_index_.match(query[0], options.max_guesses_);
+        }
+      });
+
+      auto result = std::vector<index_t>();
+      complete.measure([&]() { result = t.complete(query, options); });
+      if (engine == match_engine::GUESS) {
+        reference.emplace_back(result);
+      } else if (!result.empty() && !reference[i].empty() &&
+                 result[0] == reference[i][0]) {
+        ++same_top;
+      }
+    }
+
+    auto const index_mb =
+        static_cast<double>(t.place_index_.byte_size() +
+                            t.area_index_.byte_size()) /
+        (1024.0 * 1024.0);
+    auto const heap_mb =
+        static_cast<double>(t.memory_usage().total()) / (1024.0 * 1024.0);
+
+    t.build_hot_tier(hot_tier_options());
+    auto hot = latency();
+    for (auto const& query : queries) {
+      hot.measure([&]() { t.complete(query, options); });
+    }
+    std::cout << std::setw(8)
+              << (engine == match_engine::GUESS ? "guess" : "ngram")
+              << std::setw(12) << report.stages_[0].wall_time_s_
+              << std::setw(16)
+              << static_cast<double>(report.stages_[0].peak_rss_bytes_) /
+                     (1024.0 * 1024.0)
+              << std::setw(14) << index_mb << std::setw(12) << heap_mb
+              << std::setw(14) << guess.mean() << std::setw(14) << guess.p99()
+              << std::setw(16) << complete.mean() << std::setw(14)
+              << complete.p99() << std::setw(11)
+              << (engine == match_engine::GUESS
+                      ? 100.0
+                      : 100.0 * static_cast<double>(same_top) /
+                            static_cast<double>(queries.size()))
+              << "%" << std::setw(12) << hot.mean() << std::setw(12)
+              << hot.p99() << std::setw(11)
+              << 100.0 * t.get_tier_stats().hit_rate() << "%\n";
+  }
+}
+
+// times the score kernels of every supported simd level on arrays of the
+// size of the dense score arrays of large datasets
+void benchmark_kernels(size_t const n) {
+  auto rng = std::mt19937(0);
+  auto dist = std::uniform_real_distribution<float>(0.0F, 1.0F);
+  auto values = std::vector<float>(n);
+  auto acc = std::vector<float>(n);
+  for (auto& v : values) {
+    // mostly zeros like the similarity arrays of a real query
+    v = dist(rng) < 0.99F ? 0.0F : dist(rng);
+  }
+
+  auto const runs = 20;
+  std::cout << std::setw(8) << "level" << std::setw(16) << "select [ms]"
+            << std::setw(16) << "scale [ms]" << std::setw(20)
+            << "multiply add [ms]\n";
+  for (auto const level :
+       {simd_level::SCALAR, simd_level::SSE2, simd_level::AVX2}) {
+    if (level > max_simd_level()) {
+      continue;
+    }
+    auto const& kernels = get_score_kernels(level);
+
+    auto select = latency();
+    auto scale = latency();
+    auto multiply_add = latency();
+    auto selected = std::vector<uint32_t>();
+    selected.reserve(n);
+    for (auto run = 0; run != runs; ++run) {
+      selected.clear();
+      select.measure([&]() {
+        kernels.select_geq_(values.data(), n, 0.01F, selected);
+      });
+      scale.measure([&]() { kernels.scale_(values.data(), n, 1.0F); });
+      multiply_add.measure([&]() {
+        kernels.multiply_add_(acc.data(), values.data(), n, 0.5F);
+      });
+    }
+    std::cout << std::setw(8) << to_str(level) << std::setw(16)
+              << select.mean() / 1000.0 << std::setw(16)
+              << scale.mean() / 1000.0 << std::setw(19)
+              << multiply_add.mean() / 1000.0 << "\n";
+  }
+}
+
+// builds the reverse geocoder and times lookups of random coordinates
+// within the bounding box of all places
+void benchmark_reverse(std::string const& context_path, size_t const n) {
+  typeahead_context context;
+  {
+    std::ifstream in(context_path, std::ios::binary);
+    in.exceptions(std::ios_base::failbit);
+    cereal::BinaryInputArchive ia(in);
+    ia(context);
+  }
+  if (context.places_.empty()) {
+    return;
+  }
+
+  extract_report report;
+  report.reset_peak_rss_ = true;
+  report.start_stage("build");
+  auto const geocoder = reverse_geocoder(context);
+  report.finish_stage();
+
+  auto min = context.places_[0].coordinates_;
+  auto max = min;
+  for (auto const& p : context.places_) {
+    min = coordinates{std::min(min.lon_, p.coordinates_.lon_),
+                      std::min(min.lat_, p.coordinates_.lat_)};
+    max = coordinates{std::max(max.lon_, p.coordinates_.lon_),
+                      std::max(max.lat_, p.coordinates_.lat_)};
+  }
+  auto rng = std::mt19937(0);
+  auto lat = std::uniform_real_distribution<double>(min.lat_ / 10000000.0,
+                                                    max.lat_ / 10000000.0);
+  auto lon = std::uniform_real_distribution<double>(min.lon_ / 10000000.0,
+                                                    max.lon_ / 10000000.0);
+
+  auto lookup = latency();
+  auto distance_sum = 0.0;
+  for (auto i = size_t(0); i != n; ++i) {
+    auto const query_lat = lat(rng);
+    auto const query_lon = lon(rng);
+    lookup.measure([&]() {
+      auto const result = geocoder.lookup(query_lat, query_lon);
+      distance_sum += result.empty() ? 0.0 : result[0].distance_;
+    });
+  }
+
+  std::cout << geocoder.entries_.size() << " points, build "
+            << report.stages_[0].wall_time_s_ << "s\n"
+            << "lookup: " << lookup.mean() << "us (p99 " << lookup.p99()
+            << "us), " << 1000000.0 / lookup.mean() << " lookups/s\n"
+            << "mean distance: " << distance_sum / static_cast<double>(n)
+            << "m\n";
+}
+
+int main(int argc, char* argv[]) {
+  if ((argc == 3 || argc == 4) && strcmp(argv[1], "location-index") == 0) {
+    benchmark_location_index(argv[2], argc == 4 ? argv[3] : "");
+  } else if ((argc == 3 || argc == 4) && strcmp(argv[1], "engines") == 0) {
+    benchmark_engines(argv[2], argc == 4 ? argv[3] : "");
+  } else if ((argc == 2 || argc == 3) && strcmp(argv[1], "kernels") == 0) {
+    benchmark_kernels(argc == 3 ? std::stoul(argv[2]) : 20000000);
+  } else if ((argc == 3 || argc == 4) && strcmp(argv[1], "reverse") == 0) {
+    benchmark_reverse(argv[2], argc == 4 ? std::stoul(argv[3]) : 100000);
+  } else {
+    std::cout << "usage: " << argv[0]
+              << " location-index {input.osm.pbf} [index file]\n";
+    std::cout << "usage: " << argv[0] << " engines {context} [query file]\n";
+    std::cout << "usage: " << argv[0] << " kernels [array size]\n";
+    std::cout << "usage: " << argv[0] << " reverse {context} [lookups]\n";
+  }
+}
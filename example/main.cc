@@ -1,39 +1,30 @@
 #include <cstring>
 #include <fstream>
 #include <iostream>
-#include <regex>
 #include <sstream>
 
 #include <cereal/archives/binary.hpp>
 
 #include "address-typeahead/common.h"
 #include "address-typeahead/extractor.h"
+#include "address-typeahead/merge.h"
+#include "address-typeahead/reverse_geocoder.h"
 #include "address-typeahead/serialization.h"
 #include "address-typeahead/typeahead.h"
 
 #include "timer.h"
 
-std::string get_place_string(
-    size_t id, address_typeahead::typeahead_context const& context) {
-  std::string result;
-  result += context.get_name(id) + " { ";
-  auto const areas = context.get_area_names(id);
-  for (auto const& a : areas) {
-    result += a.first + ", ";
-  }
-  result += " }";
+std::string get_place_string(size_t id,
+                             address_typeahead::typeahead const& t) {
+  auto const& context = t.context_;
+  auto result = context.get_label(static_cast<address_typeahead::index_t>(id));
 
-  auto house_numbers = context.get_house_numbers(id);
-  std::sort(house_numbers.begin(), house_numbers.end());
+  auto const house_numbers = t.complete_house_number(
+      static_cast<address_typeahead::index_t>(id), "", 50);
   if (!house_numbers.empty()) {
     result += " { ";
-    for (size_t i = 0; i != house_numbers.size(); ++i) {
-      auto const& hn = house_numbers[i];
-      if (!std::regex_match(hn, std::regex("\\d{1,4}[:alpha:]*")) ||
-          (i + 1 != house_numbers.size() && house_numbers[i + 1] == hn)) {
-        continue;
-      }
-      result += hn + ", ";
+    for (auto const& hn : house_numbers) {
+      result += hn.house_number_ + ", ";
     }
     result += " }";
   }
@@ -44,46 +35,29 @@ std::string get_place_string(
 std::vector<address_typeahead::index_t> parse_string_and_complete(
     std::string const& str, address_typeahead::typeahead const& t,
     address_typeahead::typeahead_context const& context) {
-
-  auto ss = std::stringstream(str);
-  auto sub_strings = std::vector<std::string>();
-  auto buf = std::string();
-
-  while (ss >> buf) {
-    sub_strings.emplace_back(buf);
-  }
-
-  auto house_number = std::string("");
-  auto str_it = std::begin(sub_strings);
-  while (str_it != std::end(sub_strings)) {
-    if (std::regex_match(*str_it, std::regex("\\.|\\d{1,4}[:alpha:]*"))) {
-      house_number = *str_it;
-      str_it = sub_strings.erase(str_it);
-    } else {
-      ++str_it;
-    }
-  }
-
-  if (sub_strings.empty()) {
-    return std::vector<address_typeahead::index_t>();
-  }
-
   address_typeahead::complete_options options;
   options.max_results_ = 10;
   options.string_chain_len_ = 2;
-  auto const candidates = t.complete(sub_strings, options);
+  auto const result = t.complete(str, options);
+  auto const& candidates = result.ids_;
+  auto const& house_number = result.house_number_;
 
-  if (!house_number.empty()) {
+  if (!house_number.empty() && !candidates.empty()) {
     double lon, lat;
     if (house_number == ".") {
       if (context.get_coordinates(candidates[0], lat, lon)) {
         std::cout << "coordinates : " << lat << ", " << lon << std::endl;
       }
     } else {
-      if (context.coordinates_for_house_number(candidates[0], house_number, lat,
-                                               lon)) {
-        std::cout << "coordinates : " << lat << ", " << lon << std::endl;
-      } else {
+      // the house number is completed like the street name
+      auto const house_numbers =
+          t.complete_house_number(candidates[0], house_number, 5);
+      for (auto const& hn : house_numbers) {
+        std::cout << hn.house_number_ << " : "
+                  << hn.coordinates_.lat_ / 10000000.0 << ", "
+                  << hn.coordinates_.lon_ / 10000000.0 << std::endl;
+      }
+      if (house_numbers.empty()) {
         std::cout << "invalid house number" << std::endl;
       }
     }
@@ -110,14 +84,69 @@ void typeahead(std::string const& input_file) {
     auto candidates = parse_string_and_complete(user_input, t, context);
 
     for (auto const& c : candidates) {
-      std::cout << get_place_string(c, context) << std::endl;
+      std::cout << get_place_string(c, t) << std::endl;
     }
     ti.elapsed_time_ms();
     std::cout << std::endl;
   }
 }
 
-void extract(std::string const& input_path, std::ofstream& out) {
+void reverse(std::string const& input_file) {
+  auto in = std::ifstream(input_file, std::ios::binary);
+  in.exceptions(std::ios_base::failbit);
+
+  address_typeahead::typeahead_context context;
+  {
+    cereal::BinaryInputArchive ia(in);
+    ia(context);
+  }
+
+  address_typeahead::reverse_geocoder const geocoder(context);
+
+  std::string user_input;
+  while (std::cout << "lat lon $ " && std::getline(std::cin, user_input)) {
+    double lat, lon;
+    if (!(std::istringstream(user_input) >> lat >> lon)) {
+      continue;
+    }
+
+    auto ti = address_typeahead::timer();
+    for (auto const& r : geocoder.lookup(lat, lon, 5)) {
+      auto str = context.get_name(r.id_);
+      if (r.house_number_ != address_typeahead::NO_HOUSE_NUMBER) {
+        auto const& s = context.streets_[r.id_ - context.places_.size()];
+        str += " " + context.house_numbers_[s.house_numbers_[r.house_number_]
+                                                .hn_idx_];
+      } else if (r.interpolated_) {
+        str += " " + std::to_string(r.interpolated_number_) + " (interpolated)";
+      }
+      str += " { ";
+      for (auto const& a : context.get_area_names(r.id_)) {
+        str += a.first + ", ";
+      }
+      std::cout << str << " } " << r.distance_ << "m" << std::endl;
+    }
+    ti.elapsed_time_ms();
+    std::cout << std::endl;
+  }
+}
+
+void memory(std::string const& input_file) {
+  auto in = std::ifstream(input_file, std::ios::binary);
+  in.exceptions(std::ios_base::failbit);
+
+  address_typeahead::typeahead_context context;
+  {
+    cereal::BinaryInputArchive ia(in);
+    ia(context);
+  }
+
+  address_typeahead::typeahead const t(context);
+  t.memory_usage().write_json(std::cout);
+}
+
+void extract(std::string const& input_path, std::ofstream& out,
+             std::string const& area_cache_path) {
   auto ti = address_typeahead::timer();
 
   address_typeahead::extract_options options;
@@ -143,6 +172,9 @@ void extract(std::string const& input_path, std::ofstream& out) {
   options.blacklist_add("highway", "service");
   options.blacklist_add("highway", "bus_stop");
   options.blacklist_add("amenity", "waste_disposal");
+  options.area_cache_path_ = area_cache_path;
+  options.alias_keys_ = {"name:de", "name:en", "alt_name", "old_name"};
+  options.labels_ = true;
 
   char approx;
   std::cout << "approximate areas? (y/n) : ";
@@ -154,8 +186,32 @@ void extract(std::string const& input_path, std::ofstream& out) {
     options.approximation_lvl_ = address_typeahead::APPROX_NONE;
   }
 
+  address_typeahead::extract_report report;
+  report.reset_peak_rss_ = true;
   address_typeahead::typeahead_context context =
-      address_typeahead::extract(input_path, options);
+      address_typeahead::extract(input_path, options, report);
+  ti.elapsed_time_s();
+  report.write_json(std::cout);
+
+  {
+    cereal::BinaryOutputArchive oa(out);
+    oa(context);
+  }
+}
+
+void merge(std::vector<std::string> const& input_files, std::ofstream& out) {
+  auto ti = address_typeahead::timer();
+
+  auto contexts = std::vector<address_typeahead::typeahead_context>();
+  for (auto const& input_file : input_files) {
+    auto in = std::ifstream(input_file, std::ios::binary);
+    in.exceptions(std::ios_base::failbit);
+
+    cereal::BinaryInputArchive ia(in);
+    ia(contexts.emplace_back());
+  }
+
+  auto const context = address_typeahead::merge(contexts);
   ti.elapsed_time_s();
 
   {
@@ -165,13 +221,24 @@ void extract(std::string const& input_path, std::ofstream& out) {
 }
 
 int main(int argc, char* argv[]) {
-  if (argc == 4 && strcmp(argv[1], "extract") == 0) {
+  if ((argc == 4 || argc == 5) && strcmp(argv[1], "extract") == 0) {
     std::ofstream out(argv[3], std::ios::binary);
-    extract(argv[2], out);
+    extract(argv[2], out, argc == 5 ? argv[4] : "");
   } else if (argc == 3 && strcmp(argv[1], "typeahead") == 0) {
     typeahead(argv[2]);
+  } else if (argc == 3 && strcmp(argv[1], "reverse") == 0) {
+    reverse(argv[2]);
+  } else if (argc == 3 && strcmp(argv[1], "memory") == 0) {
+    memory(argv[2]);
+  } else if (argc >= 4 && strcmp(argv[1], "merge") == 0) {
+    std::ofstream out(argv[2], std::ios::binary);
+    merge(std::vector<std::string>(argv + 3, argv + argc), out);
   } else {
-    std::cout << "usage extract: " << argv[0] << " extract {input} {output}\n";
+    std::cout << "usage extract: " << argv[0]
+              << " extract {input} {output} [area cache]\n";
     std::cout << "usage typeahead: " << argv[0] << " typeahead {input}\n";
+    std::cout << "usage reverse: " << argv[0] << " reverse {input}\n";
+    std::cout << "usage memory: " << argv[0] << " memory {input}\n";
+    std::cout << "usage merge: " << argv[0] << " merge {output} {input}...\n";
   }
 }
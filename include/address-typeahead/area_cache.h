@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "address-typeahead/area_lookup.h"
+#include "address-typeahead/common.h"
+#include "address-typeahead/prepared_polygon.h"
+
+namespace address_typeahead {
+
+// input and options an area cache was built with, a cache is only reused
+// for the same key
+struct area_cache_key {
+  bool operator==(area_cache_key const& o) const {
+    return input_path_ == o.input_path_ && input_size_ == o.input_size_ &&
+           input_mtime_ == o.input_mtime_ &&
+           approximation_lvl_ == o.approximation_lvl_ &&
+           simplify_tolerance_ == o.simplify_tolerance_ &&
+           alias_keys_ == o.alias_keys_;
+  }
+
+  std::string input_path_;
+  uint64_t input_size_ = 0;
+  int64_t input_mtime_ = 0;
+  uint32_t approximation_lvl_ = 0;
+  int32_t simplify_tolerance_ = 0;
+  std::vector<std::string> alias_keys_;
+};
+
+// Results of the relation pass, multipolygon assembly and area lookup
+// construction. They do not depend on the place filters, so extractions
+// differing only in those can reuse them.
+struct area_cache {
+  area_cache_key key_;
+
+  std::vector<area> areas_;
+  std::vector<std::string> area_names_;
+  std::vector<alias> area_aliases_;
+  std::vector<int64_t> area_osm_ids_;
+  std::vector<uint64_t> area_population_;
+
+  // empty for approximate lookups
+  std::vector<prepared_polygon> polygons_;
+  area_lookup lookup_;
+};
+
+// returns false if the file does not exist, is not a valid cache or was
+// built for another key
+bool read_area_cache(std::string const& path, area_cache_key const& key,
+                     area_cache& cache);
+
+void write_area_cache(std::string const& path, area_cache const& cache);
+
+}  // namespace address_typeahead
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <vector>
+
+#include "address-typeahead/common.h"
+#include "address-typeahead/geometry.h"
+#include "address-typeahead/prepared_polygon.h"
+
+namespace address_typeahead {
+
+struct area_lookup_options {
+  // cells are not split below this size (osm coordinates, 1e-7 degrees)
+  int32_t min_cell_size_ = 20000;
+
+  // cells are not split further once the boundaries crossing them have at
+  // most this many edges (exact mode only)
+  size_t max_leaf_edges_ = 32;
+
+  // exact: cells crossed by a boundary keep the crossing areas and test
+  // points against their prepared polygons at lookup time
+  // approximate: crossing areas are assigned to the whole cell if they
+  // contain the cell centre, lookups never touch the polygons
+  bool exact_ = true;
+};
+
+// Adaptive quadtree over the envelope of all areas. Every cell references an
+// interned set of areas covering the complete cell; leaf cells additionally
+// reference the set of areas whose boundary crosses the cell.
+struct area_lookup {
+  struct cell {
+    // index of the first of four consecutive children, 0 for leaf cells
+    uint32_t first_child_;
+    uint32_t inside_set_;
+    uint32_t boundary_set_;
+  };
+
+  // builds the approximate lookup one polygon at a time, so the prepared
+  // polygons do not have to be kept in memory together. Adding all polygons
+  // with edges (in any order) gives the same lookup as the constructor with
+  // exact_ = false if bounds is the union of their envelopes.
+  struct approximate_builder {
+    approximate_builder(box const& bounds, area_lookup_options const& options);
+
+    void add(index_t area, prepared_polygon const& pol);
+    area_lookup finish() const;
+
+  private:
+    struct node {
+      // index of the first of four consecutive children, 0 for leaf nodes
+      uint32_t first_child_ = 0;
+      std::vector<index_t> inside_;
+    };
+
+    void add(uint32_t node_idx, box const& b, index_t area,
+             prepared_polygon const& pol, std::vector<uint32_t> const& edges,
+             unsigned depth);
+
+    void flatten(area_lookup& lookup, uint32_t cell_idx, uint32_t node_idx,
+                 box const& b,
+                 std::map<std::vector<index_t>, uint32_t>& sets) const;
+
+    box bounds_;
+    area_lookup_options options_;
+    std::vector<node> nodes_;
+  };
+
+  area_lookup() { bg::assign_inverse(bounds_); }
+  area_lookup(std::vector<prepared_polygon> const& polygons,
+              area_lookup_options const& options);
+
+  // appends the ids of all areas containing p in ascending order
+  // polygons are only required for lookups in exact mode
+  void lookup(point const& p, std::vector<prepared_polygon> const& polygons,
+              std::vector<index_t>& result) const;
+
+  box bounds_;
+  std::vector<cell> cells_;
+
+  // interned area sets, set i is [set_offsets_[i], set_offsets_[i + 1])
+  // set 0 is the empty set
+  std::vector<uint32_t> set_offsets_;
+  std::vector<index_t> set_areas_;
+
+private:
+  struct candidate {
+    index_t area_;
+    std::vector<uint32_t> edges_;
+  };
+
+  void build(uint32_t cell_idx, box const& b,
+             std::vector<candidate> const& candidates, unsigned depth,
+             std::vector<prepared_polygon> const& polygons,
+             area_lookup_options const& options,
+             std::map<std::vector<index_t>, uint32_t>& sets);
+
+  uint32_t intern(std::vector<index_t>& areas,
+                  std::map<std::vector<index_t>, uint32_t>& sets);
+};
+
+}  // namespace address_typeahead
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+namespace address_typeahead {
+
+// Blocking multi producer / multi consumer queue with a fixed capacity.
+// Producers block while the queue is full, consumers block while it is empty
+// and not yet closed.
+template <typename T>
+struct bounded_queue {
+  explicit bounded_queue(size_t const capacity) : capacity_(capacity) {}
+
+  void push(T&& el) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    not_full_.wait(lock, [&]() { return queue_.size() < capacity_ || closed_; });
+    queue_.push_back(std::move(el));
+    not_empty_.notify_one();
+  }
+
+  // returns false once the queue is closed and drained
+  bool pop(T& el) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    not_empty_.wait(lock, [&]() { return !queue_.empty() || closed_; });
+    if (queue_.empty()) {
+      return false;
+    }
+    el = std::move(queue_.front());
+    queue_.pop_front();
+    not_full_.notify_one();
+    return true;
+  }
+
+  void close() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    closed_ = true;
+    not_empty_.notify_all();
+    not_full_.notify_all();
+  }
+
+private:
+  size_t capacity_;
+  bool closed_{false};
+  std::deque<T> queue_;
+  std::mutex mutex_;
+  std::condition_variable not_empty_;
+  std::condition_variable not_full_;
+};
+
+}  // namespace address_typeahead
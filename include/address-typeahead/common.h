@@ -11,6 +11,8 @@
 #include "boost/geometry/geometries/polygon.hpp"
 #include "boost/geometry/geometries/ring.hpp"
 
+#include "address-typeahead/memory_report.h"
+
 namespace address_typeahead {
 
 using index_t = uint32_t;
@@ -65,6 +67,23 @@ struct street {
   std::vector<index_t> areas_;
 };
 
+// addr:interpolation way of a street (id_): the house numbers first_,
+// first_ + step_, ..., last_ along the polyline, positions of the numbers in
+// between are computed on demand
+struct interpolation {
+  index_t id_;
+  uint32_t first_;
+  uint32_t last_;
+  uint32_t step_;
+  std::vector<coordinates> polyline_;
+};
+
+// additional name of a place / street or area
+struct alias {
+  index_t id_;
+  index_t name_idx_;
+};
+
 struct typeahead_context {
 
   std::vector<location> places_;
@@ -75,8 +94,40 @@ struct typeahead_context {
   std::vector<std::string> area_names_;
   std::vector<std::string> house_numbers_;
 
+  // extraction metadata to merge contexts: the osm area id and population
+  // of every area and the population sum popularity_ was normalized with
+  // (popularity_ = 1 + population / population_sum_)
+  std::vector<int64_t> area_osm_ids_;
+  std::vector<uint64_t> area_population_;
+  uint64_t population_sum_{0};
+
+  // normalized search keys of names_ and area_names_ (see normalize.h),
+  // empty in contexts extracted before they were added
+  std::vector<std::string> name_keys_;
+  std::vector<std::string> area_name_keys_;
+
+  // static importance per place / street (see importance.h), empty in
+  // contexts extracted before it was added
+  std::vector<float> importance_;
+
+  // alternative names (name:*, alt_name, old_name, ...) sorted by id_:
+  // place / street ids with indices into names_ and area ids with indices
+  // into area_names_
+  std::vector<alias> aliases_;
+  std::vector<alias> area_aliases_;
+
+  // display labels (see labels.h), empty unless built: the area label of
+  // place / street i is area_labels_[label_areas_[i]]
+  std::vector<std::string> area_labels_;
+  std::vector<index_t> label_areas_;
+
+  // house number ranges sorted by id_, empty in contexts extracted before
+  // they were added
+  std::vector<interpolation> interpolations_;
+
   bool get_coordinates(index_t id, double& lat, double& lon) const;
 
+  // mapped house numbers first, then numbers covered by an interpolation
   bool coordinates_for_house_number(index_t id, std::string const& house_number,
                                     double& lat, double& lon) const;
 
@@ -86,12 +137,21 @@ struct typeahead_context {
   std::string get_name(index_t id) const;
   index_t get_name_id(index_t id) const;
 
+  // alternative names of a place / street
+  std::vector<std::string> get_aliases(index_t id) const;
+
+  // "name, area, ..., area": a lookup if the labels were built
+  std::string get_label(index_t id) const;
+
   std::vector<std::pair<std::string, uint32_t>> get_area_names(
       index_t id, uint32_t const levels = 0xffffffff) const;
   std::vector<std::string> get_house_numbers(index_t id) const;
 
   bool is_place(index_t id) const;
   bool is_street(index_t id) const;
+
+  // heap bytes per member (see memory_report.h)
+  memory_report memory_usage() const;
 };
 
 }  // namespace address_typeahead
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace address_typeahead {
+
+struct extract_stage {
+  std::string name_;
+  double wall_time_s_;
+  double cpu_time_s_;
+
+  // peak resident set size of the process up to the end of the stage, the
+  // peak of the stage itself if reset_peak_rss_ is set (linux only)
+  uint64_t peak_rss_bytes_;
+};
+
+struct extract_report {
+  // finishes the running stage (if any) and starts measuring a new one
+  void start_stage(std::string name);
+  void finish_stage();
+
+  void write_json(std::ostream& out) const;
+
+  std::string input_path_;
+  uint32_t approximation_lvl_ = 0;
+  std::string location_index_;
+  bool area_cache_hit_ = false;
+
+  std::vector<extract_stage> stages_;
+
+  // resets the peak RSS (VmHWM) of the whole process at the start of every
+  // stage, off by default as it interferes with peak memory monitoring of
+  // the host process
+  bool reset_peak_rss_ = false;
+
+  uint64_t areas_ = 0;
+  uint64_t polygons_ = 0;
+  uint64_t polygon_vertices_ = 0;
+  uint64_t polygon_store_bytes_ = 0;
+  uint64_t lookup_cells_ = 0;
+  uint64_t area_sets_ = 0;
+  uint64_t rtree_values_ = 0;
+  uint64_t locations_ = 0;
+  uint64_t places_ = 0;
+  uint64_t streets_ = 0;
+  uint64_t house_numbers_ = 0;
+  uint64_t interpolations_ = 0;
+  uint64_t names_ = 0;
+  uint64_t area_names_ = 0;
+  uint64_t house_number_names_ = 0;
+
+private:
+  bool running_ = false;
+  double wall_start_ = 0.0;
+  double cpu_start_ = 0.0;
+};
+
+}  // namespace address_typeahead
@@ -1,11 +1,19 @@
 #pragma once
 
 #include "address-typeahead/common.h"
+#include "address-typeahead/extract_report.h"
+#include "address-typeahead/parallel_for.h"
+
+#include <string>
+#include <vector>
 
 #include <osmium/tags/tags_filter.hpp>
 
 namespace address_typeahead {
 
+// APPROX_NONE assigns areas exactly, the other levels select the cell size
+// (osm coordinates) of an approximate area lookup: larger cells need less
+// memory but misassign more locations close to area boundaries
 uint32_t const APPROX_NONE(0);
 uint32_t const APPROX_LVL_1(50000);
 uint32_t const APPROX_LVL_2(100000);
@@ -14,15 +22,68 @@ uint32_t const APPROX_LVL_4(500000);
 uint32_t const APPROX_LVL_5(750000);
 uint32_t const APPROX_MAX(999999);
 
+// storage of node locations while resolving way geometries
+// FLEX_MEM: in memory, switches from sparse to dense for large inputs
+// SPARSE_MEM: in memory, sorted (id, location) pairs
+// DENSE_MMAP: anonymous memory mapping indexed by node id (linux only)
+// DENSE_FILE / SPARSE_FILE: memory mapped file, see location_index_path_
+enum class location_index_type {
+  FLEX_MEM,
+  SPARSE_MEM,
+  DENSE_MMAP,
+  DENSE_FILE,
+  SPARSE_FILE
+};
+
+char const* to_str(location_index_type);
+
 struct extract_options {
   uint32_t approximation_lvl_ = APPROX_NONE;
   osmium::TagsFilter whitelist_ = osmium::TagsFilter(false);
   osmium::TagsFilter blacklist_ = osmium::TagsFilter(false);
 
+  // threads used for area assignment and duplicate removal and for the
+  // geometry conversion of the second pass (which always uses at least one
+  // worker next to the reader and place extractor threads)
+  // the result does not depend on the number of threads
+  unsigned num_threads_ = default_num_threads();
+
+  // Douglas-Peucker tolerance for area boundaries (osm coordinates, 1e-7
+  // degrees), 0 keeps the full resolution. Borders shared by several areas
+  // are simplified once, see polygon_store::simplify
+  int32_t simplify_tolerance_ = 0;
+
+  location_index_type location_index_ = location_index_type::FLEX_MEM;
+
+  // file backing DENSE_FILE / SPARSE_FILE indices, removed after the node
+  // locations are not needed anymore (empty: anonymous temporary file)
+  std::string location_index_path_;
+
+  // file storing the areas and the area lookup after the first extraction,
+  // later extractions of the same input with the same approximation_lvl_
+  // and simplify_tolerance_ reuse it and skip the relation pass, the
+  // multipolygon assembly and the area lookup construction (empty: no cache)
+  std::string area_cache_path_;
+
+  // tags whose values are indexed as additional names of places, streets
+  // and areas (multiple values separated by ';' are split), the entities
+  // are not duplicated, e.g. {"name:de", "alt_name"} (empty: only name)
+  std::vector<std::string> alias_keys_;
+
+  // stores the display label of every place / street (see labels.h) for
+  // rendering results without computing area names
+  bool labels_ = false;
+
   void whitelist_add(std::string const& tag, std::string const& value = "");
   void blacklist_add(std::string const& tag, std::string const& value = "");
 };
 
 typeahead_context extract(std::string const& input_path,
                           extract_options const& options);
+
+// same as above, additionally records per stage timings, memory usage and
+// entity counts of the extraction in the given report
+typeahead_context extract(std::string const& input_path,
+                          extract_options const& options,
+                          extract_report& report);
 }  // namespace address_typeahead
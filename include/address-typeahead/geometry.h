@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstdint>
+
+#include "boost/geometry.hpp"
+#include "boost/geometry/geometries/box.hpp"
+#include "boost/geometry/geometries/multi_polygon.hpp"
+#include "boost/geometry/geometries/point.hpp"
+#include "boost/geometry/geometries/polygon.hpp"
+#include "boost/geometry/geometries/ring.hpp"
+
+namespace address_typeahead {
+
+namespace bg = boost::geometry;
+namespace bgi = boost::geometry::index;
+
+using point = bg::model::point<int32_t, 2, bg::cs::cartesian>;
+using box = bg::model::box<point>;
+using ring = bg::model::ring<point, false, true>;
+using polygon = bg::model::polygon<point, false, true>;
+using multi_polygon = bg::model::multi_polygon<polygon>;
+
+}  // namespace address_typeahead
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "address-typeahead/common.h"
+
+namespace address_typeahead {
+
+// Key of a house number: lower case without spaces ("13 A" -> "13a").
+std::string house_number_key(std::string_view house_number);
+
+// Natural order of house number keys: leading numbers compare by value,
+// then the remaining characters ("2" < "2a" < "10" < "a").
+bool natural_less(std::string_view a, std::string_view b);
+
+// House number suggested for a street: an address of the street or a
+// number of one of its interpolation ranges.
+struct house_number_match {
+  std::string house_number_;
+  coordinates coordinates_;
+  bool interpolated_;
+};
+
+// Prefix search in the house numbers of a street.
+//
+// The house numbers of every street are sorted by key, the house numbers
+// starting with a prefix form a range found by binary search. The numbers of
+// the interpolation ranges of the street without an address of their own are
+// enumerated per query (ranges are short, see MAX_INTERPOLATED_NUMBERS).
+struct house_number_index {
+  house_number_index() = default;
+  explicit house_number_index(typeahead_context const& context);
+
+  // house numbers of the street (index into streets_) whose key starts with
+  // the key of prefix, distinct keys only, in natural order
+  std::vector<house_number_match> match(typeahead_context const& context,
+                                        index_t street_idx,
+                                        std::string_view prefix,
+                                        size_t max_results) const;
+
+  // key per entry of context.house_numbers_
+  std::vector<std::string> keys_;
+
+  // the sorted positions in the house_numbers_ of street i are
+  // sorted_[offsets_[i]] to sorted_[offsets_[i + 1] - 1]
+  std::vector<uint64_t> offsets_;
+  std::vector<uint32_t> sorted_;
+};
+
+}  // namespace address_typeahead
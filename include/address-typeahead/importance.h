@@ -0,0 +1,18 @@
+#pragma once
+
+#include "address-typeahead/common.h"
+#include "address-typeahead/parallel_for.h"
+
+namespace address_typeahead {
+
+// Static importance of a place / street, independent of the query:
+// 1 + population share of its most populated area, streets additionally
+// grow with their number of house numbers. Values are in [1, 2), the
+// fuzzy scores are only slightly biased.
+float get_importance(typeahead_context const& context, index_t id);
+
+// fills importance_ of the context
+void add_importance(typeahead_context& context,
+                    unsigned num_threads = default_num_threads());
+
+}  // namespace address_typeahead
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "address-typeahead/common.h"
+
+namespace address_typeahead {
+
+// Assigns consecutive ids to distinct strings. Every distinct string is
+// copied once into large arena blocks, lookups do not allocate.
+struct string_interner {
+  index_t intern(std::string_view str);
+  std::string_view get(index_t id) const { return strings_[id]; }
+  size_t size() const { return strings_.size(); }
+
+private:
+  std::string_view store(std::string_view str);
+
+  std::vector<std::unique_ptr<char[]>> blocks_;
+  size_t block_used_{0};
+  size_t block_size_{0};
+
+  std::vector<std::string_view> strings_;
+  std::unordered_map<std::string_view, index_t> ids_;
+};
+
+// Assigns consecutive ids to distinct sorted sets of indices, all sets are
+// stored consecutively in one array. Id 0 is the empty set.
+struct index_set_interner {
+  index_set_interner();
+
+  index_t intern(index_t const* begin, index_t const* end);
+  std::vector<index_t> get(index_t id) const;
+  size_t size() const { return offsets_.size() - 1; }
+
+  // set i is [offsets_[i], offsets_[i + 1])
+  std::vector<index_t> data_;
+  std::vector<uint64_t> offsets_{0};
+
+private:
+  // hash of the set -> sets with this hash
+  std::unordered_map<uint64_t, std::vector<index_t>> index_;
+};
+
+}  // namespace address_typeahead
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+#include "address-typeahead/common.h"
+
+namespace address_typeahead {
+
+// house number without any suffix ("12", not "12a" or "12-14")
+bool parse_house_number(std::string_view str, uint32_t& number);
+
+// step of an addr:interpolation value: "all" 1, "odd" / "even" 2 or a
+// positive number (false for "alphabetic" and unknown values)
+bool parse_interpolation_step(std::string_view value, uint32_t& step);
+
+// position of number on the interpolation line: numbers are spaced evenly
+// along the length of the polyline, false if the range does not contain the
+// number (step included) or is invalid (step 0)
+bool interpolate(interpolation const& i, uint32_t number, coordinates& result);
+
+// ranges with more numbers are broken data and are not enumerated
+constexpr auto const MAX_INTERPOLATED_NUMBERS = uint32_t(1000);
+
+// calls fn(number) for the numbers of the range in ascending order
+template <typename Fn>
+void for_each_number(interpolation const& i, Fn&& fn) {
+  if (i.step_ == 0 || i.last_ < i.first_ ||
+      (i.last_ - i.first_) / i.step_ >= MAX_INTERPOLATED_NUMBERS) {
+    return;
+  }
+  for (auto n = i.first_; n <= i.last_; n += i.step_) {
+    fn(n);
+  }
+}
+
+}  // namespace address_typeahead
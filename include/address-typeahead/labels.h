@@ -0,0 +1,19 @@
+#pragma once
+
+#include <string>
+
+#include "address-typeahead/common.h"
+#include "address-typeahead/parallel_for.h"
+
+namespace address_typeahead {
+
+// Area part of the display label of a place / street: the names of
+// get_area_names (most local first, postcodes included) separated by ", ".
+std::string get_area_label(typeahead_context const& context, index_t id);
+
+// fills area_labels_ and label_areas_ of the context, every distinct area
+// label is stored once
+void add_labels(typeahead_context& context,
+                unsigned num_threads = default_num_threads());
+
+}  // namespace address_typeahead
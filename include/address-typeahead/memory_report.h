@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace address_typeahead {
+
+// Heap bytes per component of a data structure. Containers are counted by
+// capacity (unused capacity included) plus the heap memory of their
+// elements, hash maps additionally by buckets and nodes. Allocator
+// bookkeeping is not included.
+struct memory_report {
+  void add(std::string name, uint64_t bytes);
+
+  // adds the components of other, names prefixed by prefix
+  void add(std::string const& prefix, memory_report const& other);
+
+  uint64_t total() const;
+
+  void write_json(std::ostream& out) const;
+
+  std::vector<std::pair<std::string, uint64_t>> components_;
+};
+
+size_t heap_bytes(std::string const& str);
+
+template <typename A, typename B>
+size_t heap_bytes(std::pair<A, B> const& pair);
+
+template <typename T, typename Alloc>
+size_t heap_bytes(std::vector<T, Alloc> const& vec);
+
+template <typename K, typename V, typename Hash, typename Eq, typename Alloc>
+size_t heap_bytes(std::unordered_map<K, V, Hash, Eq, Alloc> const& map);
+
+// heap memory owned by an element (none for trivially copyable types)
+template <typename T>
+size_t element_heap_bytes(T const& element) {
+  if constexpr (std::is_trivially_copyable_v<T>) {
+    return 0;
+  } else {
+    return heap_bytes(element);
+  }
+}
+
+template <typename A, typename B>
+size_t heap_bytes(std::pair<A, B> const& pair) {
+  return element_heap_bytes(pair.first) + element_heap_bytes(pair.second);
+}
+
+template <typename T, typename Alloc>
+size_t heap_bytes(std::vector<T, Alloc> const& vec) {
+  auto bytes = vec.capacity() * sizeof(T);
+  if constexpr (!std::is_trivially_copyable_v<T>) {
+    for (auto const& element : vec) {
+      bytes += heap_bytes(element);
+    }
+  }
+  return bytes;
+}
+
+template <typename K, typename V, typename Hash, typename Eq, typename Alloc>
+size_t heap_bytes(std::unordered_map<K, V, Hash, Eq, Alloc> const& map) {
+  // one pointer per bucket, nodes: next pointer, value and cached hash
+  auto bytes =
+      map.bucket_count() * sizeof(void*) +
+      map.size() * (sizeof(void*) + sizeof(std::pair<K const, V>) +
+                    sizeof(size_t));
+  for (auto const& [key, value] : map) {
+    bytes += element_heap_bytes(key) + element_heap_bytes(value);
+  }
+  return bytes;
+}
+
+}  // namespace address_typeahead
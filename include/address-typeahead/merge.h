@@ -0,0 +1,26 @@
+#pragma once
+
+#include <vector>
+
+#include "address-typeahead/common.h"
+#include "address-typeahead/parallel_for.h"
+
+namespace address_typeahead {
+
+// Merges contexts extracted from separate (possibly overlapping) regions
+// into one context.
+//
+// Areas are identified by their osm id (contexts without area_osm_ids_ fall
+// back to level and name), their popularity is renormalized with the
+// population sum of the merged areas. Names, area names and house numbers
+// are deduplicated. Places and streets with the same name and area set are
+// combined like in a single extraction: streets unite their house numbers,
+// places next to a street of the same name are dropped.
+// Display labels are rebuilt if any of the contexts has them.
+//
+// Everything is ordered like in extract() (see canonicalize): merging the
+// extracts of several regions gives the extract of the combined region.
+typeahead_context merge(std::vector<typeahead_context> const& contexts,
+                        unsigned num_threads = default_num_threads());
+
+}  // namespace address_typeahead
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstdint>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "address-typeahead/common.h"
+
+namespace address_typeahead {
+
+struct ngram_match {
+  index_t index_;
+  float cos_sim_;
+};
+
+// Trigram inverted index over weighted strings for fuzzy candidate
+// generation, an alternative to guess::guesser.
+//
+// Strings are lower cased (ASCII) and padded with a space on both sides.
+// The score of a candidate is the cosine similarity of the trigram sets of
+// query and candidate multiplied by the candidate weight.
+//
+// Posting lists are delta / varint encoded in blocks of POSTING_BLOCK_SIZE
+// candidates. Top-k queries use WAND: a candidate is only scored if the
+// upper bounds of the lists containing it can reach the current k-th best
+// score, lists that cannot contribute skip ahead block by block.
+struct ngram_index {
+  static constexpr auto const POSTING_BLOCK_SIZE = 64U;
+
+  struct term {
+    uint32_t gram_;
+    uint32_t count_;
+
+    // blocks of this term are [first_block_, next term's first_block_)
+    uint32_t first_block_;
+
+    // max weight / sqrt(#trigrams) of all candidates in the list
+    float max_score_;
+  };
+
+  struct block {
+    uint32_t first_;
+    uint32_t last_;
+
+    // deltas of the remaining candidates start at postings_[offset_]
+    uint64_t offset_;
+  };
+
+  ngram_index() = default;
+  explicit ngram_index(
+      std::vector<std::pair<std::string, float>> const& strings);
+
+  // best count candidates by descending score (ties: ascending index)
+  std::vector<ngram_match> match(std::string const& str, size_t count) const;
+
+  // same, results and temporaries are allocated from the resource of results
+  void match(std::string_view str, size_t count,
+             std::pmr::vector<ngram_match>& results) const;
+
+  size_t size() const { return candidate_scores_.size(); }
+  size_t byte_size() const;
+
+  // sorted by gram_, terminated by a sentinel
+  std::vector<term> terms_;
+  std::vector<block> blocks_;
+  std::vector<uint8_t> postings_;
+
+  // weight / sqrt(#trigrams) per candidate
+  std::vector<float> candidate_scores_;
+
+private:
+  void add_term(uint32_t gram, uint32_t const* begin, uint32_t const* end);
+};
+
+// Scores few strings like ngram_index::match without building an index
+// (e.g. the candidates of a query when reranking). Memory is allocated from
+// the given resource, matching from the resource of the results.
+struct ngram_scorer {
+  explicit ngram_scorer(std::pmr::memory_resource* resource);
+
+  void add(std::string_view str, float weight);
+
+  // best count strings by descending score (ties: ascending index)
+  void match(std::string_view str, size_t count,
+             std::pmr::vector<ngram_match>& results) const;
+
+  size_t size() const { return scores_.size(); }
+
+  // trigrams of string i: grams_[offsets_[i], offsets_[i + 1])
+  std::pmr::vector<uint32_t> grams_;
+  std::pmr::vector<uint32_t> offsets_;
+
+  // weight / sqrt(#trigrams) per string
+  std::pmr::vector<float> scores_;
+
+private:
+  std::pmr::vector<uint32_t> trigrams_;
+};
+
+// distinct trigrams of the lower cased, padded string (sorted)
+void get_trigrams(std::string_view str, std::vector<uint32_t>& trigrams);
+void get_trigrams(std::string_view str, std::pmr::vector<uint32_t>& trigrams);
+
+}  // namespace address_typeahead
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <memory_resource>
+#include <string>
+#include <string_view>
+
+#include "address-typeahead/common.h"
+#include "address-typeahead/parallel_for.h"
+
+namespace address_typeahead {
+
+// Search key of a name: lower case, german umlauts transliterated (ä -> ae,
+// ß -> ss), other latin diacritics removed (é -> e), whitespace collapsed
+// and street abbreviations expanded ("Hauptstr." -> "hauptstrasse").
+// "Straße", "Strasse" and "Str." as well as "München" and "Muenchen" have
+// the same key.
+std::string normalize(std::string_view str);
+
+// same, writes the key to out (allocated from the resource of out)
+void normalize(std::string_view str, std::pmr::string& out);
+
+// fills name_keys_ and area_name_keys_ of the context
+void add_search_keys(typeahead_context& context,
+                     unsigned num_threads = default_num_threads());
+
+}  // namespace address_typeahead
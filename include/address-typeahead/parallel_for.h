@@ -0,0 +1,62 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace address_typeahead {
+
+inline unsigned default_num_threads() {
+  return std::max(1U, std::thread::hardware_concurrency());
+}
+
+// Calls fn(i) for every i in [0, count) using up to num_threads threads.
+// Work items are handed out one at a time, so results must only be written
+// to slots owned by the work item to stay independent of the thread count.
+template <typename Fn>
+void parallel_for(size_t const count, unsigned const num_threads, Fn&& fn) {
+  auto const thread_count = std::min(static_cast<size_t>(num_threads), count);
+  if (thread_count <= 1) {
+    for (size_t i = 0; i != count; ++i) {
+      fn(i);
+    }
+    return;
+  }
+
+  std::atomic<size_t> next{0};
+  std::exception_ptr exception;
+  std::mutex exception_mutex;
+
+  auto const work = [&]() {
+    try {
+      for (auto i = next++; i < count; i = next++) {
+        fn(i);
+      }
+    } catch (...) {
+      std::lock_guard<std::mutex> lock(exception_mutex);
+      if (!exception) {
+        exception = std::current_exception();
+      }
+      next = count;
+    }
+  };
+
+  auto threads = std::vector<std::thread>();
+  threads.reserve(thread_count - 1);
+  for (size_t i = 1; i != thread_count; ++i) {
+    threads.emplace_back(work);
+  }
+  work();
+  for (auto& t : threads) {
+    t.join();
+  }
+
+  if (exception) {
+    std::rethrow_exception(exception);
+  }
+}
+
+}  // namespace address_typeahead
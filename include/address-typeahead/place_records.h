@@ -0,0 +1,63 @@
+#pragma once
+
+#include <vector>
+
+#include "address-typeahead/common.h"
+#include "address-typeahead/interner.h"
+
+namespace address_typeahead {
+
+// a named location: a street (way or node), an address (house number != 0)
+// or a place, names and house numbers are interned
+struct place_record {
+  index_t name_idx_;
+  index_t hn_idx_;
+  coordinates coordinates_;
+  index_t area_set_;
+};
+
+// additional name (alias_idx_, interned like the names) of the place /
+// street built from the records with name_idx_ and area_set_
+struct alias_record {
+  index_t name_idx_;
+  index_t area_set_;
+  index_t alias_idx_;
+};
+
+// house number range (interpolation_.id_ unused) of the street built from
+// the records with name_idx_ and area_set_
+struct interpolation_record {
+  index_t name_idx_;
+  index_t area_set_;
+  interpolation interpolation_;
+};
+
+// Renumbers everything into the order shared by extract() and merge(), so
+// the result does not depend on how the data was collected: areas ordered
+// by osm id (by level and name without osm ids), area names, names and
+// house numbers sorted (unreferenced names and house numbers are dropped),
+// area sets ordered by their areas. Sets population_sum_ and the popularity
+// of the areas from area_population_.
+void canonicalize(typeahead_context& context,
+                  std::vector<place_record>& records,
+                  std::vector<alias_record>& aliases,
+                  std::vector<interpolation_record>& interpolations,
+                  string_interner& names, string_interner& house_numbers,
+                  index_set_interner& area_sets);
+
+// Builds names_, places_, streets_, aliases_ and interpolations_ of the
+// context from the records. Records with the same name and area set are
+// combined: a group without any house number becomes a place (at the
+// largest coordinates of the group), otherwise a street with the house
+// numbers and ranges of the group (ranges of a place are dropped).
+// Identical records are kept once. The output is ordered by name id, then
+// by area set id.
+void remove_duplicates(typeahead_context& context,
+                       std::vector<place_record> const& records,
+                       std::vector<alias_record> aliases,
+                       std::vector<interpolation_record> interpolations,
+                       string_interner const& names,
+                       index_set_interner const& area_sets,
+                       unsigned num_threads);
+
+}  // namespace address_typeahead
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "address-typeahead/common.h"
+#include "address-typeahead/geometry.h"
+
+namespace address_typeahead {
+
+// Compact storage of multi polygons.
+//
+// Ring vertices are delta encoded (zigzag varints) into one byte array.
+// Identical rings (e.g. an admin boundary that is also a postcode boundary)
+// are stored only once and referenced by all multi polygons using them.
+struct polygon_store {
+  index_t add(multi_polygon const& mp);
+  multi_polygon get(index_t id) const;
+
+  size_t size() const { return polygon_offsets_.size() - 1; }
+  size_t byte_size() const;
+
+  // envelope of multi polygon id without decoding it into a multi_polygon,
+  // false if it has no edge (like prepared_polygon)
+  bool envelope(index_t id, box& result) const;
+
+  // Topology preserving Douglas-Peucker simplification of all rings
+  // (tolerance in osm coordinates). The rings are split into arcs at
+  // junctions (vertices with different neighbours in different rings or
+  // ring positions), every distinct arc is simplified once with fixed end
+  // points and the rings are rebuilt from the simplified arcs: borders
+  // shared by several areas stay shared. Arcs used by a polygon whose
+  // simplification degenerates a ring or intersects are kept unchanged.
+  void simplify(int32_t tolerance);
+
+  // ring i is [ring_offsets_[i], ring_offsets_[i + 1])
+  std::vector<uint8_t> ring_data_;
+  std::vector<uint64_t> ring_offsets_{0};
+
+  // multi polygon i is [polygon_offsets_[i], polygon_offsets_[i + 1]) and
+  // contains: #polygons, then per polygon #rings followed by the ring ids
+  // (outer ring first)
+  std::vector<uint32_t> polygon_rings_;
+  std::vector<uint64_t> polygon_offsets_{0};
+
+private:
+  uint32_t add_ring(ring const& r);
+  void read_ring(uint32_t ring_id, std::vector<point>& result) const;
+
+  // hash of the encoded ring -> rings with this hash
+  std::unordered_map<uint64_t, std::vector<uint32_t>> ring_index_;
+};
+
+}  // namespace address_typeahead
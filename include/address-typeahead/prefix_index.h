@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "address-typeahead/common.h"
+
+namespace address_typeahead {
+
+// Exact prefix matching over (normalized) strings, answers inputs that are
+// too short for the fuzzy matchers.
+//
+// The strings are stored sorted, the strings with a common prefix form a
+// range found by binary search. For all one and two byte prefixes the TOP_K
+// best strings by static score are precomputed, these queries only copy a
+// list.
+struct prefix_index {
+  static constexpr auto const TOP_K = 32U;
+
+  prefix_index() = default;
+  prefix_index(std::vector<std::string> const& strings,
+               std::vector<float> const& scores);
+
+  // indices of the best count strings starting with prefix by descending
+  // score (ties: ascending index)
+  std::vector<index_t> match(std::string_view prefix, size_t count) const;
+
+  size_t size() const { return sorted_.size(); }
+
+  // string indices sorted by string, the string of sorted_[i] is
+  // [chars_ + offsets_[i], chars_ + offsets_[i + 1])
+  std::vector<index_t> sorted_;
+  std::vector<uint64_t> offsets_;
+  std::string chars_;
+  std::vector<float> scores_;
+
+  // top list of short prefix p is [top_offsets_[slot(p)],
+  // top_offsets_[slot(p) + 1]) in top_
+  std::vector<uint32_t> top_offsets_;
+  std::vector<index_t> top_;
+
+private:
+  std::string_view get(size_t sorted_idx) const;
+  void top_k(size_t from, size_t to, size_t count,
+             std::vector<index_t>& result) const;
+};
+
+}  // namespace address_typeahead
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "address-typeahead/geometry.h"
+
+namespace address_typeahead {
+
+// Multi polygon prepared for repeated point in polygon tests.
+//
+// All ring vertices are stored in one flat array. The envelope is divided
+// into horizontal strips and every strip lists the edges overlapping it, so
+// a test only looks at the edges crossing the strip of the point instead of
+// all edges of the polygon.
+struct prepared_polygon {
+  prepared_polygon() = default;
+  explicit prepared_polygon(multi_polygon const& mp);
+
+  // same semantics as bg::within: points on the boundary are not within
+  bool within(point const& p) const;
+
+  box envelope_;
+  std::vector<point> vertices_;
+
+  int64_t strip_height_ = 1;
+  std::vector<uint32_t> strip_offsets_;
+
+  // edge i connects vertices_[i] and vertices_[i + 1]
+  std::vector<uint32_t> strip_edges_;
+};
+
+}  // namespace address_typeahead
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <memory_resource>
+#include <string_view>
+#include <vector>
+
+#include "address-typeahead/common.h"
+
+namespace address_typeahead {
+
+// WORD: part of a name
+// HOUSE_NUMBER: 1-4 digits followed by letters only ("13", "13a") or "."
+// (asks for the street itself)
+// POSTCODE: 5 or more digits
+// SEPARATOR: ',' or ';', strings are not chained across separators
+enum class token_type { WORD, HOUSE_NUMBER, POSTCODE, SEPARATOR };
+
+struct query_token {
+  // part of the query
+  std::string_view str_;
+  token_type type_;
+
+  // value of POSTCODE tokens
+  index_t postcode_ = 0;
+};
+
+// Splits a raw query at whitespace and separators and classifies the
+// tokens in one pass. Tokens refer to the query, words are normalized when
+// they are matched.
+void tokenize(std::string_view query, std::pmr::vector<query_token>& tokens);
+
+}  // namespace address_typeahead
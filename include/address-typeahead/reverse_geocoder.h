@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "address-typeahead/common.h"
+#include "address-typeahead/geometry.h"
+
+namespace address_typeahead {
+
+constexpr auto const NO_HOUSE_NUMBER = std::numeric_limits<index_t>::max();
+
+struct reverse_result {
+  // place / street id, the area chain is context.get_area_names(id_)
+  index_t id_;
+
+  // index into the house_numbers_ of street id_, NO_HOUSE_NUMBER for places
+  // and interpolated house numbers
+  index_t house_number_;
+
+  double distance_;  // meters
+
+  // number of an interpolation range of street id_ without an address of
+  // its own (see interpolation.h), house_number_ is NO_HOUSE_NUMBER
+  bool interpolated_ = false;
+  uint32_t interpolated_number_ = 0;
+};
+
+// Nearest places and house numbers (mapped or interpolated) of a coordinate.
+//
+// All places and house numbers are points on the unit sphere in a packed
+// (bulk loaded) rtree. The euclidean distance of two points on the sphere
+// grows with their great circle distance, the nearest neighbours of the
+// rtree are the geographically nearest ones.
+struct reverse_geocoder {
+  using sphere_point = bg::model::point<double, 3, bg::cs::cartesian>;
+  using value = std::pair<sphere_point, uint32_t>;
+
+  // interpolated: street id_ without house_number_
+  struct entry {
+    index_t id_;
+    index_t house_number_;
+    uint32_t interpolated_number_;
+  };
+
+  explicit reverse_geocoder(typeahead_context const& context);
+
+  // the count nearest places / house numbers by ascending distance
+  std::vector<reverse_result> lookup(double lat, double lon,
+                                     size_t count = 1) const;
+
+  std::vector<entry> entries_;
+  size_t num_places_;
+  bgi::rtree<value, bgi::linear<16>> rtree_;
+};
+
+}  // namespace address_typeahead
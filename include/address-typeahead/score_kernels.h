@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace address_typeahead {
+
+enum class simd_level { SCALAR, SSE2, AVX2 };
+
+char const* to_str(simd_level);
+
+// highest level supported by the cpu (SCALAR on non x86 platforms)
+simd_level max_simd_level();
+
+// Kernels for the dense score arrays of typeahead::complete().
+// All levels produce bit identical results.
+struct score_kernels {
+  // appends the indices i with values[i] >= threshold in ascending order
+  void (*select_geq_)(float const* values, size_t n, float threshold,
+                      std::vector<uint32_t>& out);
+
+  // values[i] *= factor
+  void (*scale_)(float* values, size_t n, float factor);
+
+  // acc[i] += values[i] * weight
+  void (*multiply_add_)(float* acc, float const* values, size_t n,
+                        float weight);
+};
+
+// kernels of the given level, clamped to max_simd_level()
+score_kernels const& get_score_kernels(simd_level level);
+
+// kernels of max_simd_level(), selected once at runtime
+score_kernels const& get_score_kernels();
+
+}  // namespace address_typeahead
@@ -1,5 +1,10 @@
 #pragma once
 
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <string>
+
 #include <cereal/cereal.hpp>
 #include <cereal/types/string.hpp>
 #include <cereal/types/vector.hpp>
@@ -34,9 +39,77 @@ void serialize(Archive& archive, street& s) {
 }
 
 template <class Archive>
-void serialize(Archive& archive, typeahead_context& tc) {
+void serialize(Archive& archive, interpolation& i) {
+  archive(i.id_, i.first_, i.last_, i.step_, i.polyline_);
+}
+
+template <class Archive>
+void serialize(Archive& archive, alias& a) {
+  archive(a.id_, a.name_idx_);
+}
+
+// Snapshot format of typeahead_context. Version 0 is the original layout
+// without any header; later versions start with CONTEXT_FORMAT_MARKER (where
+// version 0 stores the number of places) and the version. Appended fields
+// bump the version and are only loaded from snapshots that contain them.
+// Data missing in old snapshots is computed by the typeahead constructor.
+//
+// version 1: area osm ids, population sum, search keys, importance,
+//            aliases, labels and interpolations
+// version 2: area population
+constexpr auto const CONTEXT_FORMAT_MARKER =
+    std::numeric_limits<uint64_t>::max();
+constexpr auto const CONTEXT_FORMAT_VERSION = uint32_t(2);
+
+template <class Archive>
+void save(Archive& archive, typeahead_context const& tc) {
+  archive(CONTEXT_FORMAT_MARKER, CONTEXT_FORMAT_VERSION);
   archive(tc.places_, tc.streets_, tc.areas_, tc.names_, tc.area_names_,
           tc.house_numbers_);
+  archive(tc.area_osm_ids_, tc.population_sum_, tc.name_keys_,
+          tc.area_name_keys_, tc.importance_, tc.aliases_, tc.area_aliases_,
+          tc.area_labels_, tc.label_areas_, tc.interpolations_);
+  archive(tc.area_population_);
+}
+
+template <class Archive>
+void load(Archive& archive, typeahead_context& tc) {
+  tc = typeahead_context();
+
+  auto marker = uint64_t(0);
+  auto version = uint32_t(0);
+  archive(marker);
+  if (marker == CONTEXT_FORMAT_MARKER) {
+    archive(version);
+    if (version > CONTEXT_FORMAT_VERSION) {
+      throw cereal::Exception("unsupported context format version " +
+                              std::to_string(version));
+    }
+    archive(tc.places_);
+  } else {
+    // version 0: the marker is the size of places_
+    tc.places_.resize(marker);
+    for (auto& place : tc.places_) {
+      archive(place);
+    }
+  }
+  archive(tc.streets_, tc.areas_, tc.names_, tc.area_names_,
+          tc.house_numbers_);
+
+  if (version >= 1) {
+    archive(tc.area_osm_ids_, tc.population_sum_, tc.name_keys_,
+            tc.area_name_keys_, tc.importance_, tc.aliases_, tc.area_aliases_,
+            tc.area_labels_, tc.label_areas_, tc.interpolations_);
+
+    // a range without a step contains no numbers
+    tc.interpolations_.erase(
+        std::remove_if(begin(tc.interpolations_), end(tc.interpolations_),
+                       [](interpolation const& i) { return i.step_ == 0; }),
+        end(tc.interpolations_));
+  }
+  if (version >= 2) {
+    archive(tc.area_population_);
+  }
 }
 
 }  // namespace address_typeahead
@@ -1,15 +1,33 @@
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <future>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
 #include <string>
+#include <string_view>
+#include <thread>
 #include <unordered_map>
 #include <vector>
 
 #include <guess/guesser.h>
 
+#include "bounded_queue.h"
 #include "common.h"
+#include "house_number_index.h"
+#include "ngram_index.h"
+#include "prefix_index.h"
+#include "query_tokenizer.h"
 
 namespace address_typeahead {
 
+// area levels are single bits of a 32 bit value
+constexpr auto const NUM_LEVEL_BITS = size_t(32);
+
 struct complete_options {
   bool first_string_is_place_ = false;
 
@@ -25,11 +43,74 @@ struct complete_options {
   // by using a string_chain_len_ > 1 the complete functions evaluates multiple
   // sequential strings together instead of evaluating each string in isolation
   size_t string_chain_len_ = 1;
+
+  // latency budget (0: unlimited), checked between the stages: once it is
+  // exceeded no further strings are guessed and the rerank is skipped
+  std::chrono::microseconds time_budget_{0};
+
+  // consult the hot tier first (if built, see build_hot_tier)
+  bool use_hot_tier_ = true;
 };
 
+struct hot_tier_options {
+  // number of places / streets in the hot tier
+  size_t size_ = 10000;
+
+  // result ids of past queries (e.g. from a query log): the most frequent
+  // ones are taken, static importance fills up the rest
+  std::vector<index_t> query_log_;
+
+  // the hot tier answers a query if it finds max_results_ results and the
+  // best one matches at least this share of the query strings
+  float min_confidence_ = 0.8F;
+};
+
+// queries of the hot tier: answered by it / passed on to the full index
+struct tier_stats {
+  double hit_rate() const {
+    auto const queries = hot_hits_ + fallbacks_;
+    return queries == 0 ? 0.0
+                        : static_cast<double>(hot_hits_) /
+                              static_cast<double>(queries);
+  }
+
+  uint64_t hot_hits_ = 0;
+  uint64_t fallbacks_ = 0;
+};
+
+// set by the caller to stop a running completion (e.g. one superseded by
+// the next keystroke)
+struct cancel_token {
+  void cancel() { cancelled_.store(true, std::memory_order_relaxed); }
+  bool cancelled() const { return cancelled_.load(std::memory_order_relaxed); }
+
+  std::atomic<bool> cancelled_{false};
+};
+
+// COMPLETE: all stages ran
+// DEGRADED: the time budget was exceeded, ids_ are the first phase results
+// CANCELLED: stopped by the cancel_token, ids_ is empty
+enum class complete_status { COMPLETE, DEGRADED, CANCELLED };
+
+struct complete_result {
+  std::vector<index_t> ids_;
+  complete_status status_ = complete_status::COMPLETE;
+
+  // last house number token of a raw query (see tokenize), empty otherwise
+  std::string house_number_{};
+};
+
+// fuzzy name matching used for candidate generation
+// GUESS: guess::guesser, allocates per query (query strings, the candidate
+//        names of the rerank and a guesser over them)
+// NGRAM: ngram_index (compressed trigram index, WAND top-k), steady state
+//        queries only allocate their result
+enum class match_engine { GUESS, NGRAM };
+
 struct typeahead {
 
-  explicit typeahead(typeahead_context context);
+  explicit typeahead(typeahead_context context,
+                     match_engine engine = match_engine::NGRAM);
 
   std::vector<index_t> complete(std::vector<std::string> const& strings,
                                 size_t max_results = 10) const;
@@ -37,16 +118,149 @@ struct typeahead {
   std::vector<index_t> complete(std::vector<std::string> const& strings,
                                 complete_options const& options) const;
 
+  // checks token (may be null) and the time budget between the stages
+  complete_result complete(std::vector<std::string> const& strings,
+                           complete_options const& options,
+                           cancel_token const* token) const;
+
+  // raw query ("gartenstr 13, 27568 bremerhaven"): tokenized instead of
+  // split by the caller, house numbers are not matched but returned
+  complete_result complete(std::string_view query,
+                           complete_options const& options,
+                           cancel_token const* token = nullptr) const;
+
+  // runs complete() on a worker thread of the typeahead (started by the
+  // first call), the typeahead has to outlive the returned future. Dropping
+  // the future does not block, the query still runs unless token cancels it.
+  // Destroying the typeahead waits for the queued queries.
+  std::future<complete_result> complete_async(
+      std::vector<std::string> strings, complete_options options,
+      std::shared_ptr<cancel_token const> token = nullptr) const;
+
+  // exact prefix matches of the normalized prefix, best names first
+  // (answers inputs shorter than three characters, which complete() ignores
+  // otherwise)
+  std::vector<index_t> complete_prefix(std::string const& prefix,
+                                       size_t max_results = 10) const;
+
+  // house numbers of street id starting with prefix (ignoring case and
+  // spaces) in natural order including interpolated numbers, empty for places
+  std::vector<house_number_match> complete_house_number(
+      index_t id, std::string const& prefix, size_t max_results = 10) const;
+
+  // heap bytes per component including the context (see memory_report.h)
+  memory_report memory_usage() const;
+
+  // small typeahead over the most popular places / streets, complete()
+  // falls back to the full index if its answer is not confident enough
+  // (prefix and postcode only queries always use the full index), may run
+  // concurrently to complete(): the new tier is published when it is built
+  void build_hot_tier(hot_tier_options const& options);
+
+  tier_stats get_tier_stats() const;
+
   std::vector<std::vector<index_t>> place_guess_to_index_;
   std::vector<std::vector<index_t>> area_guess_to_index_;
   std::unordered_map<index_t, std::vector<index_t>> postcode_to_index_;
 
+  // most areas of one place / street per level (by level bit) and most
+  // postcode areas of one place / street, bound the first phase score
+  std::array<size_t, NUM_LEVEL_BITS> max_level_areas_{};
+  size_t max_postcode_areas_ = 0;
+
   typeahead_context context_;
+  match_engine engine_;
+
+  // only the guessers / indices of the selected engine are built
   guess::guesser place_guesser_;
   guess::guesser area_guesser_;
+  ngram_index place_index_;
+  ngram_index area_index_;
+
+  // names by normalized key, scored by the importance of the most
+  // important place / street with the name
+  prefix_index prefix_index_;
+
+  house_number_index house_number_index_;
+
+  // entity i of the hot tier is ids_[i]
+  struct hot_tier {
+    std::unique_ptr<typeahead> typeahead_;
+    std::vector<index_t> ids_;
+    float min_confidence_ = 0.0F;
+  };
+
+  // null unless built, replaced by build_hot_tier (std::atomic_store) while
+  // completions may run: each query loads it once (std::atomic_load)
+  std::shared_ptr<hot_tier const> hot_tier_;
 
 private:
-  mutable std::vector<std::pair<index_t, float>> acc_;
+  // confidence (may be null): share of the query matched by the best result
+  complete_result complete_tokens(std::pmr::vector<query_token> const& tokens,
+                                  complete_options const& options,
+                                  cancel_token const* token,
+                                  float* confidence = nullptr) const;
+
+  void guess_match(guess::guesser const& guesser, ngram_index const& index,
+                   std::string_view str, size_t count,
+                   std::pmr::vector<ngram_match>& result) const;
+
+  // area ids of a place / street (without copying them)
+  std::vector<index_t> const& areas_of(index_t const id) const {
+    return context_.is_place(id)
+               ? context_.places_[id].areas_
+               : context_.streets_[id - context_.places_.size()].areas_;
+  }
+
+  // area of an entry of area_guesser_ / area_index_ (see get_names)
+  index_t area_of_guess(index_t const guess) const {
+    return guess < context_.areas_.size()
+               ? guess
+               : context_.area_aliases_[guess - context_.areas_.size()].id_;
+  }
+
+  // static importance descending, ties: ascending id
+  bool more_important(index_t const a, index_t const b) const {
+    auto const& importance = context_.importance_;
+    return importance[a] > importance[b] ||
+           (importance[a] == importance[b] && a < b);
+  }
+
+  // memory of a complete() call, kept for later calls (concurrent calls
+  // each take their own): selected indices, the first phase top and an
+  // arena for the other temporaries of the query, which grows until steady
+  // state queries fit into it
+  struct query_scratch {
+    std::vector<uint32_t> selected_;
+    std::vector<uint32_t> top_;
+    std::vector<std::byte> arena_;
+  };
+  struct scratch_pool {
+    std::unique_ptr<query_scratch> take();
+    void put_back(std::unique_ptr<query_scratch> scratch);
+
+    std::mutex mutex_;
+    std::vector<std::unique_ptr<query_scratch>> free_;
+  };
+  std::unique_ptr<scratch_pool> scratch_pool_;
+
+  struct tier_counters {
+    std::atomic<uint64_t> hot_hits_{0};
+    std::atomic<uint64_t> fallbacks_{0};
+  };
+  std::unique_ptr<tier_counters> tier_counters_;
+
+  // worker threads of complete_async(), declared last: destroyed first, the
+  // workers finish the queued queries while the rest is still alive
+  struct async_executor {
+    ~async_executor();
+    void submit(std::packaged_task<complete_result()> task);
+
+    std::once_flag started_;
+    bounded_queue<std::packaged_task<complete_result()>> queue_{1024};
+    std::vector<std::thread> workers_;
+  };
+  std::unique_ptr<async_executor> async_executor_;
 };
 
 }  // namespace address_typeahead
@@ -0,0 +1,208 @@
+#include "address-typeahead/area_cache.h"
+
+#include <algorithm>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+
+#include "cereal/archives/binary.hpp"
+
+#include "address-typeahead/serialization.h"
+
+namespace address_typeahead {
+
+// incremented whenever the layout below changes
+constexpr auto const AREA_CACHE_VERSION = uint32_t(3);
+
+template <class Archive>
+void serialize(Archive& archive, area_cache_key& k) {
+  archive(k.input_path_, k.input_size_, k.input_mtime_, k.approximation_lvl_,
+          k.simplify_tolerance_, k.alias_keys_);
+}
+
+template <class Archive>
+void serialize(Archive& archive, area_lookup::cell& c) {
+  archive(c.first_child_, c.inside_set_, c.boundary_set_);
+}
+
+namespace {
+
+// boost geometry points are written as coordinate pairs
+
+void write_points(cereal::BinaryOutputArchive& oa,
+                  std::vector<point> const& points) {
+  auto coordinates = std::vector<int32_t>();
+  coordinates.reserve(points.size() * 2);
+  for (auto const& p : points) {
+    coordinates.push_back(p.get<0>());
+    coordinates.push_back(p.get<1>());
+  }
+  oa(coordinates);
+}
+
+std::vector<point> read_points(cereal::BinaryInputArchive& ia) {
+  auto coordinates = std::vector<int32_t>();
+  ia(coordinates);
+  auto points = std::vector<point>();
+  points.reserve(coordinates.size() / 2);
+  for (auto i = size_t(0); i + 1 < coordinates.size(); i += 2) {
+    points.emplace_back(coordinates[i], coordinates[i + 1]);
+  }
+  return points;
+}
+
+void write_box(cereal::BinaryOutputArchive& oa, box const& b) {
+  write_points(oa, {b.min_corner(), b.max_corner()});
+}
+
+box read_box(cereal::BinaryInputArchive& ia) {
+  auto const corners = read_points(ia);
+  if (corners.size() != 2) {
+    throw cereal::Exception("invalid box");
+  }
+  return box(corners[0], corners[1]);
+}
+
+// lookups do not check indices, a cache read from disk is only used if all
+// of them are in range
+bool is_valid(prepared_polygon const& p) {
+  if (p.strip_offsets_.empty()) {
+    return true;
+  }
+  auto const height = static_cast<int64_t>(p.envelope_.max_corner().get<1>()) -
+                      p.envelope_.min_corner().get<1>();
+  return p.strip_height_ > 0 && height >= 0 &&
+         height / p.strip_height_ + 2 <=
+             static_cast<int64_t>(p.strip_offsets_.size()) &&
+         p.strip_offsets_.front() == 0 &&
+         p.strip_offsets_.back() == p.strip_edges_.size() &&
+         std::is_sorted(begin(p.strip_offsets_), end(p.strip_offsets_)) &&
+         std::all_of(begin(p.strip_edges_), end(p.strip_edges_),
+                     [&](uint32_t const e) {
+                       return e + size_t(1) < p.vertices_.size();
+                     });
+}
+
+bool is_valid(area_cache const& cache) {
+  auto const num_areas = cache.areas_.size();
+  if (!cache.polygons_.empty() && cache.polygons_.size() != num_areas) {
+    return false;
+  }
+  if (!std::all_of(begin(cache.polygons_), end(cache.polygons_),
+                   [](prepared_polygon const& p) { return is_valid(p); })) {
+    return false;
+  }
+  if (!std::all_of(begin(cache.area_aliases_), end(cache.area_aliases_),
+                   [&](alias const& a) {
+                     return a.id_ < num_areas &&
+                            a.name_idx_ < cache.area_names_.size();
+                   })) {
+    return false;
+  }
+
+  auto const& l = cache.lookup_;
+  if (l.cells_.empty()) {
+    return true;
+  }
+  if (l.set_offsets_.empty() || l.set_offsets_.front() != 0 ||
+      l.set_offsets_.back() != l.set_areas_.size() ||
+      !std::is_sorted(begin(l.set_offsets_), end(l.set_offsets_)) ||
+      !std::all_of(begin(l.set_areas_), end(l.set_areas_),
+                   [&](index_t const a) { return a < num_areas; })) {
+    return false;
+  }
+
+  // children follow their parent, lookups always terminate
+  auto const num_sets = l.set_offsets_.size() - 1;
+  for (auto i = size_t(0); i != l.cells_.size(); ++i) {
+    auto const& c = l.cells_[i];
+    auto const valid_children =
+        c.first_child_ == 0 ||
+        (c.first_child_ > i && c.first_child_ + size_t(4) <= l.cells_.size());
+    if (c.inside_set_ >= num_sets || c.boundary_set_ >= num_sets ||
+        !valid_children) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+bool read_area_cache(std::string const& path, area_cache_key const& key,
+                     area_cache& cache) {
+  std::ifstream in(path, std::ios::binary);
+  if (!in) {
+    return false;
+  }
+
+  try {
+    cereal::BinaryInputArchive ia(in);
+
+    auto version = uint32_t(0);
+    ia(version);
+    if (version != AREA_CACHE_VERSION) {
+      return false;
+    }
+
+    ia(cache.key_);
+    if (!(cache.key_ == key)) {
+      return false;
+    }
+
+    ia(cache.areas_, cache.area_names_, cache.area_aliases_,
+       cache.area_osm_ids_, cache.area_population_);
+
+    auto num_polygons = uint64_t(0);
+    ia(num_polygons);
+    cache.polygons_.resize(num_polygons);
+    for (auto& p : cache.polygons_) {
+      p.envelope_ = read_box(ia);
+      p.vertices_ = read_points(ia);
+      ia(p.strip_height_, p.strip_offsets_, p.strip_edges_);
+    }
+
+    cache.lookup_.bounds_ = read_box(ia);
+    ia(cache.lookup_.cells_, cache.lookup_.set_offsets_,
+       cache.lookup_.set_areas_);
+  } catch (std::exception const&) {
+    // also std::bad_alloc / std::length_error for corrupt sizes
+    cache = area_cache();
+    return false;
+  }
+
+  if (!is_valid(cache)) {
+    cache = area_cache();
+    return false;
+  }
+  return true;
+}
+
+void write_area_cache(std::string const& path, area_cache const& cache) {
+  // written to a temporary file first, an interrupted run never leaves a
+  // truncated cache behind
+  auto const tmp_path = path + ".tmp";
+  {
+    std::ofstream out(tmp_path, std::ios::binary);
+    out.exceptions(std::ios_base::failbit | std::ios_base::badbit);
+    cereal::BinaryOutputArchive oa(out);
+
+    oa(AREA_CACHE_VERSION, cache.key_);
+    oa(cache.areas_, cache.area_names_, cache.area_aliases_,
+       cache.area_osm_ids_, cache.area_population_);
+
+    oa(static_cast<uint64_t>(cache.polygons_.size()));
+    for (auto const& p : cache.polygons_) {
+      write_box(oa, p.envelope_);
+      write_points(oa, p.vertices_);
+      oa(p.strip_height_, p.strip_offsets_, p.strip_edges_);
+    }
+
+    write_box(oa, cache.lookup_.bounds_);
+    oa(cache.lookup_.cells_, cache.lookup_.set_offsets_,
+       cache.lookup_.set_areas_);
+  }
+  std::filesystem::rename(tmp_path, path);
+}
+
+}  // namespace address_typeahead
@@ -0,0 +1,329 @@
+#include "address-typeahead/area_lookup.h"
+
+#include <algorithm>
+
+namespace address_typeahead {
+
+namespace {
+
+constexpr auto const MAX_DEPTH = 24U;
+
+int32_t mid(int32_t const min, int32_t const max) {
+  return static_cast<int32_t>(min + (static_cast<int64_t>(max) - min) / 2);
+}
+
+box child_box(box const& b, unsigned const child) {
+  auto const min_x = b.min_corner().get<0>();
+  auto const min_y = b.min_corner().get<1>();
+  auto const max_x = b.max_corner().get<0>();
+  auto const max_y = b.max_corner().get<1>();
+  auto const mid_x = mid(min_x, max_x);
+  auto const mid_y = mid(min_y, max_y);
+  return box(point((child & 1U) != 0U ? mid_x + 1 : min_x,
+                   (child & 2U) != 0U ? mid_y + 1 : min_y),
+             point((child & 1U) != 0U ? max_x : mid_x,
+                   (child & 2U) != 0U ? max_y : mid_y));
+}
+
+unsigned child_of(box const& b, point const& p) {
+  auto const mid_x = mid(b.min_corner().get<0>(), b.max_corner().get<0>());
+  auto const mid_y = mid(b.min_corner().get<1>(), b.max_corner().get<1>());
+  return (p.get<0>() > mid_x ? 1U : 0U) | (p.get<1>() > mid_y ? 2U : 0U);
+}
+
+bool is_empty(box const& b) {
+  return b.min_corner().get<0>() > b.max_corner().get<0>() ||
+         b.min_corner().get<1>() > b.max_corner().get<1>();
+}
+
+point centre(box const& b) {
+  return point(mid(b.min_corner().get<0>(), b.max_corner().get<0>()),
+               mid(b.min_corner().get<1>(), b.max_corner().get<1>()));
+}
+
+// conservative: edges passing (almost) exactly through a corner intersect
+bool intersects(point const& a, point const& b, box const& cell) {
+  auto const ax = static_cast<double>(a.get<0>());
+  auto const ay = static_cast<double>(a.get<1>());
+  auto const bx = static_cast<double>(b.get<0>());
+  auto const by = static_cast<double>(b.get<1>());
+  auto const min_x = static_cast<double>(cell.min_corner().get<0>());
+  auto const min_y = static_cast<double>(cell.min_corner().get<1>());
+  auto const max_x = static_cast<double>(cell.max_corner().get<0>());
+  auto const max_y = static_cast<double>(cell.max_corner().get<1>());
+
+  if (std::max(ax, bx) < min_x || std::min(ax, bx) > max_x ||
+      std::max(ay, by) < min_y || std::min(ay, by) > max_y) {
+    return false;
+  }
+
+  auto const side = [&](double const x, double const y) {
+    constexpr auto const TOLERANCE = 4096.0;
+    auto const cross = (bx - ax) * (y - ay) - (by - ay) * (x - ax);
+    return cross > TOLERANCE ? 1 : (cross < -TOLERANCE ? -1 : 0);
+  };
+  auto const s0 = side(min_x, min_y);
+  auto const s1 = side(max_x, min_y);
+  auto const s2 = side(min_x, max_y);
+  auto const s3 = side(max_x, max_y);
+  return !((s0 > 0 && s1 > 0 && s2 > 0 && s3 > 0) ||
+           (s0 < 0 && s1 < 0 && s2 < 0 && s3 < 0));
+}
+
+}  // namespace
+
+area_lookup::area_lookup(std::vector<prepared_polygon> const& polygons,
+                         area_lookup_options const& options) {
+  bg::assign_inverse(bounds_);
+  auto candidates = std::vector<candidate>();
+  for (index_t i = 0; i != polygons.size(); ++i) {
+    auto const& pol = polygons[i];
+    if (pol.strip_edges_.empty()) {
+      continue;
+    }
+
+    bg::expand(bounds_, pol.envelope_);
+
+    // long edges are listed in several strips
+    auto edges = pol.strip_edges_;
+    std::sort(edges.begin(), edges.end());
+    edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+    candidates.push_back(candidate{i, std::move(edges)});
+  }
+
+  auto sets = std::map<std::vector<index_t>, uint32_t>();
+  auto empty = std::vector<index_t>();
+  intern(empty, sets);
+
+  // without any area there is no tree, lookups return before using bounds_
+  if (candidates.empty()) {
+    return;
+  }
+
+  cells_.resize(1);
+  build(0, bounds_, candidates, 0, polygons, options, sets);
+}
+
+void area_lookup::build(uint32_t const cell_idx, box const& b,
+                        std::vector<candidate> const& candidates,
+                        unsigned const depth,
+                        std::vector<prepared_polygon> const& polygons,
+                        area_lookup_options const& options,
+                        std::map<std::vector<index_t>, uint32_t>& sets) {
+  auto inside = std::vector<index_t>();
+  auto crossing = std::vector<candidate>();
+  auto crossing_edges = size_t(0);
+  auto const c = centre(b);
+  for (auto const& cand : candidates) {
+    auto const& pol = polygons[cand.area_];
+    auto edges = std::vector<uint32_t>();
+    for (auto const e : cand.edges_) {
+      if (intersects(pol.vertices_[e], pol.vertices_[e + 1], b)) {
+        edges.push_back(e);
+      }
+    }
+
+    // no boundary within the cell: completely inside or outside
+    if (edges.empty()) {
+      if (pol.within(c)) {
+        inside.push_back(cand.area_);
+      }
+      continue;
+    }
+
+    crossing_edges += edges.size();
+    crossing.push_back(candidate{cand.area_, std::move(edges)});
+  }
+
+  auto const width = static_cast<int64_t>(b.max_corner().get<0>()) -
+                     b.min_corner().get<0>();
+  auto const height = static_cast<int64_t>(b.max_corner().get<1>()) -
+                      b.min_corner().get<1>();
+  auto const is_leaf =
+      crossing.empty() || depth == MAX_DEPTH ||
+      std::max(width, height) <= options.min_cell_size_ ||
+      (options.exact_ && crossing_edges <= options.max_leaf_edges_);
+
+  auto boundary = std::vector<index_t>();
+  if (is_leaf) {
+    for (auto const& cand : crossing) {
+      if (options.exact_) {
+        boundary.push_back(cand.area_);
+      } else if (polygons[cand.area_].within(c)) {
+        inside.push_back(cand.area_);
+      }
+    }
+  }
+
+  cells_[cell_idx].first_child_ = 0;
+  cells_[cell_idx].inside_set_ = intern(inside, sets);
+  cells_[cell_idx].boundary_set_ = intern(boundary, sets);
+  if (is_leaf) {
+    return;
+  }
+
+  auto const first_child = static_cast<uint32_t>(cells_.size());
+  cells_[cell_idx].first_child_ = first_child;
+  cells_.resize(cells_.size() + 4, cell{0, 0, 0});
+  for (auto child = 0U; child != 4U; ++child) {
+    auto const child_b = child_box(b, child);
+    if (!is_empty(child_b)) {
+      build(first_child + child, child_b, crossing, depth + 1, polygons,
+            options, sets);
+    }
+  }
+}
+
+uint32_t area_lookup::intern(std::vector<index_t>& areas,
+                             std::map<std::vector<index_t>, uint32_t>& sets) {
+  std::sort(areas.begin(), areas.end());
+  auto it = sets.find(areas);
+  if (it == sets.end()) {
+    if (set_offsets_.empty()) {
+      set_offsets_.push_back(0);
+    }
+    set_areas_.insert(set_areas_.end(), areas.begin(), areas.end());
+    set_offsets_.push_back(static_cast<uint32_t>(set_areas_.size()));
+    it = sets.emplace(areas, static_cast<uint32_t>(sets.size())).first;
+  }
+  return it->second;
+}
+
+area_lookup::approximate_builder::approximate_builder(
+    box const& bounds, area_lookup_options const& options)
+    : bounds_(bounds), options_(options) {}
+
+void area_lookup::approximate_builder::add(index_t const area,
+                                           prepared_polygon const& pol) {
+  if (pol.strip_edges_.empty()) {
+    return;
+  }
+
+  if (nodes_.empty()) {
+    nodes_.resize(1);
+  }
+
+  // long edges are listed in several strips
+  auto edges = pol.strip_edges_;
+  std::sort(edges.begin(), edges.end());
+  edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+  add(0, bounds_, area, pol, edges, 0);
+}
+
+// same decisions as area_lookup::build for a single candidate: a node is
+// split as soon as the first boundary crosses it
+void area_lookup::approximate_builder::add(uint32_t const node_idx,
+                                           box const& b, index_t const area,
+                                           prepared_polygon const& pol,
+                                           std::vector<uint32_t> const& edges,
+                                           unsigned const depth) {
+  auto crossing = std::vector<uint32_t>();
+  for (auto const e : edges) {
+    if (intersects(pol.vertices_[e], pol.vertices_[e + 1], b)) {
+      crossing.push_back(e);
+    }
+  }
+
+  auto const width = static_cast<int64_t>(b.max_corner().get<0>()) -
+                     b.min_corner().get<0>();
+  auto const height = static_cast<int64_t>(b.max_corner().get<1>()) -
+                      b.min_corner().get<1>();
+  if (crossing.empty() || depth == MAX_DEPTH ||
+      std::max(width, height) <= options_.min_cell_size_) {
+    if (pol.within(centre(b))) {
+      nodes_[node_idx].inside_.push_back(area);
+    }
+    return;
+  }
+
+  if (nodes_[node_idx].first_child_ == 0) {
+    nodes_[node_idx].first_child_ = static_cast<uint32_t>(nodes_.size());
+    nodes_.resize(nodes_.size() + 4);
+  }
+  auto const first_child = nodes_[node_idx].first_child_;
+  for (auto child = 0U; child != 4U; ++child) {
+    auto const child_b = child_box(b, child);
+    if (!is_empty(child_b)) {
+      add(first_child + child, child_b, area, pol, crossing, depth + 1);
+    }
+  }
+}
+
+area_lookup area_lookup::approximate_builder::finish() const {
+  auto lookup = area_lookup();
+  auto sets = std::map<std::vector<index_t>, uint32_t>();
+  auto empty = std::vector<index_t>();
+  lookup.intern(empty, sets);
+
+  // without any area there is no tree, lookups return before using bounds_
+  if (nodes_.empty()) {
+    return lookup;
+  }
+
+  lookup.bounds_ = bounds_;
+  lookup.cells_.resize(1);
+  flatten(lookup, 0, 0, bounds_, sets);
+  return lookup;
+}
+
+// cells are laid out in the order area_lookup::build creates them
+void area_lookup::approximate_builder::flatten(
+    area_lookup& lookup, uint32_t const cell_idx, uint32_t const node_idx,
+    box const& b, std::map<std::vector<index_t>, uint32_t>& sets) const {
+  auto const& n = nodes_[node_idx];
+  auto inside = n.inside_;
+  auto boundary = std::vector<index_t>();
+  lookup.cells_[cell_idx].first_child_ = 0;
+  lookup.cells_[cell_idx].inside_set_ = lookup.intern(inside, sets);
+  lookup.cells_[cell_idx].boundary_set_ = lookup.intern(boundary, sets);
+  if (n.first_child_ == 0) {
+    return;
+  }
+
+  auto const first_child = static_cast<uint32_t>(lookup.cells_.size());
+  lookup.cells_[cell_idx].first_child_ = first_child;
+  lookup.cells_.resize(lookup.cells_.size() + 4, cell{0, 0, 0});
+  for (auto child = 0U; child != 4U; ++child) {
+    auto const child_b = child_box(b, child);
+    if (!is_empty(child_b)) {
+      flatten(lookup, first_child + child, n.first_child_ + child, child_b,
+              sets);
+    }
+  }
+}
+
+void area_lookup::lookup(point const& p,
+                         std::vector<prepared_polygon> const& polygons,
+                         std::vector<index_t>& result) const {
+  if (cells_.empty() || !bg::covered_by(p, bounds_)) {
+    return;
+  }
+
+  auto const first_result = result.size();
+  auto b = bounds_;
+  auto cell_idx = uint32_t(0);
+  while (true) {
+    auto const& c = cells_[cell_idx];
+    result.insert(result.end(),
+                  begin(set_areas_) + set_offsets_[c.inside_set_],
+                  begin(set_areas_) + set_offsets_[c.inside_set_ + 1]);
+
+    if (c.first_child_ == 0) {
+      for (auto i = set_offsets_[c.boundary_set_];
+           i != set_offsets_[c.boundary_set_ + 1]; ++i) {
+        auto const area_idx = set_areas_[i];
+        if (area_idx < polygons.size() && polygons[area_idx].within(p)) {
+          result.push_back(area_idx);
+        }
+      }
+      break;
+    }
+
+    auto const child = child_of(b, p);
+    b = child_box(b, child);
+    cell_idx = c.first_child_ + child;
+  }
+  std::sort(begin(result) + first_result, end(result));
+}
+
+}  // namespace address_typeahead
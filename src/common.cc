@@ -1,5 +1,10 @@
 #include "address-typeahead/common.h"
 
+#include <algorithm>
+
+#include "address-typeahead/interpolation.h"
+#include "address-typeahead/labels.h"
+
 namespace address_typeahead {
 
 bool typeahead_context::get_coordinates(index_t id, double& lat,
@@ -33,6 +38,24 @@ bool typeahead_context::coordinates_for_house_number(
       return true;
     }
   }
+
+  auto number = uint32_t(0);
+  if (!parse_house_number(house_number, number)) {
+    return false;
+  }
+  auto it = std::lower_bound(
+      interpolations_.begin(), interpolations_.end(), id,
+      [](interpolation const& i, index_t const other) {
+        return i.id_ < other;
+      });
+  for (; it != interpolations_.end() && it->id_ == id; ++it) {
+    auto c = coordinates();
+    if (interpolate(*it, number, c)) {
+      lon = c.lon_ / 10000000.0;
+      lat = c.lat_ / 10000000.0;
+      return true;
+    }
+  }
   return false;
 }
 
@@ -75,6 +98,34 @@ index_t typeahead_context::get_name_id(index_t id) const {
   return 0;
 }
 
+std::vector<std::string> typeahead_context::get_aliases(index_t id) const {
+  auto result = std::vector<std::string>();
+  auto it = std::lower_bound(
+      aliases_.begin(), aliases_.end(), id,
+      [](alias const& a, index_t const other) { return a.id_ < other; });
+  for (; it != aliases_.end() && it->id_ == id; ++it) {
+    result.emplace_back(names_[it->name_idx_]);
+  }
+  return result;
+}
+
+std::string typeahead_context::get_label(index_t id) const {
+  if (!is_place(id) && !is_street(id)) {
+    return "";
+  }
+  auto const has_labels =
+      label_areas_.size() == places_.size() + streets_.size();
+  auto const computed = has_labels ? std::string() : get_area_label(*this, id);
+  auto const& area_label =
+      has_labels ? area_labels_[label_areas_[id]] : computed;
+
+  auto label = get_name(id);
+  if (!area_label.empty()) {
+    label += ", " + area_label;
+  }
+  return label;
+}
+
 std::vector<std::pair<std::string, uint32_t>> typeahead_context::get_area_names(
     index_t id, uint32_t const levels) const {
   auto result = std::vector<std::pair<std::string, uint32_t>>();
@@ -113,6 +164,28 @@ std::vector<std::string> typeahead_context::get_house_numbers(
     for (auto const& hn : str.house_numbers_) {
       result.emplace_back(house_numbers_[hn.hn_idx_]);
     }
+
+    // followed by the interpolated numbers without an address of their own
+    auto numbers = std::vector<uint32_t>();
+    auto it = std::lower_bound(
+        interpolations_.begin(), interpolations_.end(), id,
+        [](interpolation const& i, index_t const other) {
+          return i.id_ < other;
+        });
+    for (; it != interpolations_.end() && it->id_ == id; ++it) {
+      for_each_number(*it, [&](uint32_t const n) { numbers.emplace_back(n); });
+    }
+    std::sort(begin(numbers), end(numbers));
+    numbers.erase(std::unique(begin(numbers), end(numbers)), end(numbers));
+
+    auto mapped = std::vector<std::string>(begin(result), end(result));
+    std::sort(begin(mapped), end(mapped));
+    for (auto const n : numbers) {
+      auto number = std::to_string(n);
+      if (!std::binary_search(begin(mapped), end(mapped), number)) {
+        result.emplace_back(std::move(number));
+      }
+    }
   }
   return result;
 }
@@ -125,4 +198,45 @@ bool typeahead_context::is_street(index_t id) const {
   return (id >= places_.size() && id < places_.size() + streets_.size());
 }
 
+memory_report typeahead_context::memory_usage() const {
+  auto place_areas = size_t(0);
+  for (auto const& p : places_) {
+    place_areas += heap_bytes(p.areas_);
+  }
+  auto street_areas = size_t(0);
+  auto street_house_numbers = size_t(0);
+  for (auto const& s : streets_) {
+    street_areas += heap_bytes(s.areas_);
+    street_house_numbers += heap_bytes(s.house_numbers_);
+  }
+
+  auto interpolation_bytes =
+      interpolations_.capacity() * sizeof(interpolation);
+  for (auto const& i : interpolations_) {
+    interpolation_bytes += heap_bytes(i.polyline_);
+  }
+
+  auto report = memory_report();
+  report.add("places_", places_.capacity() * sizeof(location));
+  report.add("places_.areas_", place_areas);
+  report.add("streets_", streets_.capacity() * sizeof(street));
+  report.add("streets_.areas_", street_areas);
+  report.add("streets_.house_numbers_", street_house_numbers);
+  report.add("areas_", heap_bytes(areas_));
+  report.add("names_", heap_bytes(names_));
+  report.add("area_names_", heap_bytes(area_names_));
+  report.add("house_numbers_", heap_bytes(house_numbers_));
+  report.add("area_osm_ids_", heap_bytes(area_osm_ids_));
+  report.add("area_population_", heap_bytes(area_population_));
+  report.add("name_keys_", heap_bytes(name_keys_));
+  report.add("area_name_keys_", heap_bytes(area_name_keys_));
+  report.add("importance_", heap_bytes(importance_));
+  report.add("aliases_", heap_bytes(aliases_));
+  report.add("area_aliases_", heap_bytes(area_aliases_));
+  report.add("area_labels_", heap_bytes(area_labels_));
+  report.add("label_areas_", heap_bytes(label_areas_));
+  report.add("interpolations_", interpolation_bytes);
+  return report;
+}
+
 }  // namespace address_typeahead
@@ -32,6 +32,8 @@ void extract(std::string const& input_path, std::ofstream& out) {
   options.blacklist_add("highway", "service");
   options.blacklist_add("highway", "bus_stop");
   options.blacklist_add("amenity", "waste_disposal");
+  options.alias_keys_ = {"name:de", "name:en", "alt_name", "old_name"};
+  options.labels_ = true;
   options.approximation_lvl_ = address_typeahead::APPROX_LVL_3;
 
   auto const context = address_typeahead::extract(input_path, options);
@@ -0,0 +1,180 @@
+#include "address-typeahead/extract_report.h"
+
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#include <sys/time.h>
+#endif
+
+namespace address_typeahead {
+
+namespace {
+
+double wall_time() {
+  using std::chrono::duration;
+  using std::chrono::steady_clock;
+  return duration<double>(steady_clock::now().time_since_epoch()).count();
+}
+
+#ifdef _WIN32
+
+double cpu_time() {
+  FILETIME creation, exit, kernel, user;
+  if (GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user) ==
+      0) {
+    return 0.0;
+  }
+  auto const to_100ns = [](FILETIME const& ft) {
+    return (static_cast<uint64_t>(ft.dwHighDateTime) << 32U) |
+           ft.dwLowDateTime;
+  };
+  return static_cast<double>(to_100ns(kernel) + to_100ns(user)) / 1e7;
+}
+
+void reset_peak_rss() {}
+
+uint64_t peak_rss() {
+  PROCESS_MEMORY_COUNTERS counters;
+  if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)) ==
+      0) {
+    return 0;
+  }
+  return counters.PeakWorkingSetSize;
+}
+
+#else
+
+double cpu_time() {
+  rusage usage{};
+  getrusage(RUSAGE_SELF, &usage);
+  auto const to_s = [](timeval const& tv) {
+    return static_cast<double>(tv.tv_sec) +
+           static_cast<double>(tv.tv_usec) / 1e6;
+  };
+  return to_s(usage.ru_utime) + to_s(usage.ru_stime);
+}
+
+// Linux allows resetting the peak RSS (VmHWM) of the process since 4.0,
+// which makes the peak attributable to a single stage (opt-in, the reset
+// is visible to everything else reading VmHWM).
+void reset_peak_rss() {
+#ifdef __linux__
+  std::ofstream clear_refs("/proc/self/clear_refs");
+  if (clear_refs) {
+    clear_refs << "5";
+  }
+#endif
+}
+
+uint64_t peak_rss() {
+#ifdef __linux__
+  std::ifstream status("/proc/self/status");
+  std::string line;
+  while (std::getline(status, line)) {
+    if (line.compare(0, 6, "VmHWM:") == 0) {
+      return std::stoull(line.substr(6)) * 1024;
+    }
+  }
+#endif
+
+  rusage usage{};
+  getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+  return static_cast<uint64_t>(usage.ru_maxrss);
+#else
+  return static_cast<uint64_t>(usage.ru_maxrss) * 1024;
+#endif
+}
+
+#endif
+
+void write_json_string(std::ostream& out, std::string const& str) {
+  out << '"';
+  for (auto const c : str) {
+    switch (c) {
+      case '"': out << "\\\""; break;
+      case '\\': out << "\\\\"; break;
+      case '\n': out << "\\n"; break;
+      case '\t': out << "\\t"; break;
+      default: out << c;
+    }
+  }
+  out << '"';
+}
+
+}  // namespace
+
+void extract_report::start_stage(std::string name) {
+  finish_stage();
+
+  if (reset_peak_rss_) {
+    reset_peak_rss();
+  }
+  stages_.push_back(extract_stage{std::move(name), 0.0, 0.0, 0});
+  running_ = true;
+  wall_start_ = wall_time();
+  cpu_start_ = cpu_time();
+}
+
+void extract_report::finish_stage() {
+  if (!running_) {
+    return;
+  }
+
+  auto& stage = stages_.back();
+  stage.wall_time_s_ = wall_time() - wall_start_;
+  stage.cpu_time_s_ = cpu_time() - cpu_start_;
+  stage.peak_rss_bytes_ = peak_rss();
+  running_ = false;
+}
+
+void extract_report::write_json(std::ostream& out) const {
+  out << "{\n  \"input\": ";
+  write_json_string(out, input_path_);
+  out << ",\n  \"approximation_lvl\": " << approximation_lvl_;
+  out << ",\n  \"location_index\": ";
+  write_json_string(out, location_index_);
+  out << ",\n  \"area_cache_hit\": " << (area_cache_hit_ ? "true" : "false");
+
+  out << ",\n  \"stages\": [";
+  for (size_t i = 0; i != stages_.size(); ++i) {
+    auto const& stage = stages_[i];
+    out << (i == 0 ? "\n" : ",\n") << "    {\"name\": ";
+    write_json_string(out, stage.name_);
+    out << ", \"wall_time_s\": " << stage.wall_time_s_
+        << ", \"cpu_time_s\": " << stage.cpu_time_s_
+        << ", \"peak_rss_bytes\": " << stage.peak_rss_bytes_ << "}";
+  }
+  auto const counts = std::vector<std::pair<char const*, uint64_t>>{
+      {"areas", areas_},
+      {"polygons", polygons_},
+      {"polygon_vertices", polygon_vertices_},
+      {"polygon_store_bytes", polygon_store_bytes_},
+      {"lookup_cells", lookup_cells_},
+      {"area_sets", area_sets_},
+      {"rtree_values", rtree_values_},
+      {"locations", locations_},
+      {"places", places_},
+      {"streets", streets_},
+      {"house_numbers", house_numbers_},
+      {"interpolations", interpolations_},
+      {"names", names_},
+      {"area_names", area_names_},
+      {"house_number_names", house_number_names_}};
+  out << "\n  ],\n  \"counts\": {";
+  for (size_t i = 0; i != counts.size(); ++i) {
+    out << (i == 0 ? "\n" : ",\n") << "    \"" << counts[i].first
+        << "\": " << counts[i].second;
+  }
+  out << "\n  }\n}\n";
+}
+
+}  // namespace address_typeahead
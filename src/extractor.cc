@@ -1,21 +1,41 @@
 #include "address-typeahead/extractor.h"
 
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <exception>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <tuple>
 #include <unordered_map>
 #include <vector>
 
-#include "boost/geometry.hpp"
-#include "boost/geometry/geometries/box.hpp"
-#include "boost/geometry/geometries/multi_polygon.hpp"
-#include "boost/geometry/geometries/point.hpp"
-#include "boost/geometry/geometries/polygon.hpp"
-#include "boost/geometry/geometries/ring.hpp"
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#include <sys/stat.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 #include "osmium/area/assembler.hpp"
 #include "osmium/area/multipolygon_manager.hpp"
 #include "osmium/dynamic_handler.hpp"
 #include "osmium/handler.hpp"
 #include "osmium/handler/node_locations_for_ways.hpp"
+#include "osmium/index/map/dense_file_array.hpp"
+#include "osmium/index/map/dense_mmap_array.hpp"
 #include "osmium/index/map/flex_mem.hpp"
+#include "osmium/index/map/sparse_file_array.hpp"
+#include "osmium/index/map/sparse_mem_array.hpp"
 #include "osmium/io/pbf_input.hpp"
 #include "osmium/io/xml_input.hpp"
 #include "osmium/memory/buffer.hpp"
@@ -24,28 +44,223 @@
 
 #include "utl/progress_tracker.h"
 
+#include "address-typeahead/area_cache.h"
+#include "address-typeahead/area_lookup.h"
+#include "address-typeahead/bounded_queue.h"
 #include "address-typeahead/common.h"
+#include "address-typeahead/geometry.h"
+#include "address-typeahead/importance.h"
+#include "address-typeahead/interner.h"
+#include "address-typeahead/interpolation.h"
+#include "address-typeahead/labels.h"
+#include "address-typeahead/normalize.h"
+#include "address-typeahead/place_records.h"
+#include "address-typeahead/polygon_store.h"
+#include "address-typeahead/prepared_polygon.h"
+
+using value = std::pair<address_typeahead::box, address_typeahead::index_t>;
+
+using index_type =
+    osmium::index::map::Map<osmium::unsigned_object_id_type, osmium::Location>;
+using location_handler_type = osmium::handler::NodeLocationsForWays<index_type>;
 
-namespace bg = boost::geometry;
-namespace bgi = boost::geometry::index;
+namespace address_typeahead {
 
-using point = bg::model::point<int32_t, 2, bg::cs::cartesian>;
-using box = bg::model::box<point>;
-using ring = bg::model::ring<point, false, true>;
-using polygon = bg::model::polygon<point, false, true>;
-using multi_polygon = bg::model::multi_polygon<polygon>;
-using value = std::pair<box, address_typeahead::index_t>;
+char const* to_str(location_index_type const type) {
+  switch (type) {
+    case location_index_type::FLEX_MEM: return "flex_mem";
+    case location_index_type::SPARSE_MEM: return "sparse_mem";
+    case location_index_type::DENSE_MMAP: return "dense_mmap";
+    case location_index_type::DENSE_FILE: return "dense_file";
+    case location_index_type::SPARSE_FILE: return "sparse_file";
+  }
+  return "";
+}
 
-using index_type = osmium::index::map::FlexMem<osmium::unsigned_object_id_type,
-                                               osmium::Location>;
-using location_handler_type = osmium::handler::NodeLocationsForWays<index_type>;
+template <template <typename, typename> class Map>
+std::unique_ptr<index_type> make_file_index(int const fd) {
+  using map_type = Map<osmium::unsigned_object_id_type, osmium::Location>;
+  if (fd == -1) {
+    return std::make_unique<map_type>();
+  }
+  return std::make_unique<map_type>(fd);
+}
 
-namespace address_typeahead {
+constexpr auto const QUEUE_CAPACITY = size_t(64);
+
+// drains the queue even after fn failed (the producer would block otherwise)
+// and rethrows the first exception afterwards
+template <typename T, typename Fn>
+void consume(bounded_queue<T>& queue, Fn&& fn) {
+  auto el = T();
+  std::exception_ptr exception;
+  while (queue.pop(el)) {
+    if (exception) {
+      continue;
+    }
+    try {
+      fn(el);
+    } catch (...) {
+      exception = std::current_exception();
+    }
+  }
+  if (exception) {
+    std::rethrow_exception(exception);
+  }
+}
+
+// threads of the second pass pipeline, join() rethrows the first exception
+// raised by one of them
+struct pipeline_workers {
+  template <typename Fn>
+  void run(Fn&& fn) {
+    threads_.emplace_back([this, fn]() {
+      try {
+        fn();
+      } catch (...) {
+        std::lock_guard<std::mutex> lock(exception_mutex_);
+        if (!exception_) {
+          exception_ = std::current_exception();
+        }
+      }
+    });
+  }
+
+  void join() {
+    for (auto& t : threads_) {
+      t.join();
+    }
+    threads_.clear();
+    if (exception_) {
+      std::rethrow_exception(exception_);
+    }
+  }
+
+  std::vector<std::thread> threads_;
+  std::mutex exception_mutex_;
+  std::exception_ptr exception_;
+};
+
+// node location index together with the file backing it (if any)
+struct location_index {
+  explicit location_index(extract_options const& options)
+      : path_(options.location_index_path_) {
+    using osmium::Location;
+    using osmium::unsigned_object_id_type;
+    using namespace osmium::index::map;
+
+    auto const is_file_backed =
+        options.location_index_ == location_index_type::DENSE_FILE ||
+        options.location_index_ == location_index_type::SPARSE_FILE;
+    if (is_file_backed && !path_.empty()) {
+#ifdef _WIN32
+      fd_ = _open(path_.c_str(), _O_RDWR | _O_CREAT | _O_TRUNC | _O_BINARY,
+                  _S_IREAD | _S_IWRITE);
+#else
+      fd_ = ::open(path_.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);  // NOLINT
+#endif
+      if (fd_ == -1) {
+        throw std::system_error(errno, std::system_category(),
+                                "could not open location index " + path_);
+      }
+    }
+
+    switch (options.location_index_) {
+      case location_index_type::FLEX_MEM:
+        index_ = std::make_unique<
+            FlexMem<unsigned_object_id_type, Location>>();
+        break;
+      case location_index_type::SPARSE_MEM:
+        index_ = std::make_unique<
+            SparseMemArray<unsigned_object_id_type, Location>>();
+        break;
+      case location_index_type::DENSE_MMAP:
+#ifdef __linux__
+        index_ = std::make_unique<
+            DenseMmapArray<unsigned_object_id_type, Location>>();
+        break;
+#else
+        throw std::runtime_error("dense_mmap location index requires linux");
+#endif
+      case location_index_type::DENSE_FILE:
+        index_ = make_file_index<DenseFileArray>(fd_);
+        break;
+      case location_index_type::SPARSE_FILE:
+        index_ = make_file_index<SparseFileArray>(fd_);
+        break;
+    }
+  }
+
+  ~location_index() { release(); }
+
+  location_index(location_index const&) = delete;
+  location_index(location_index&&) = delete;
+  location_index& operator=(location_index const&) = delete;
+  location_index& operator=(location_index&&) = delete;
+
+  void release() {
+    index_.reset();
+    if (fd_ != -1) {
+#ifdef _WIN32
+      _close(fd_);
+#else
+      ::close(fd_);
+#endif
+      fd_ = -1;
+      std::remove(path_.c_str());
+    }
+  }
+
+  std::string path_;
+  int fd_{-1};
+  std::unique_ptr<index_type> index_;
+};
+
+// calls fn with every value of the alias tags, values separated by ';' are
+// split
+template <typename Fn>
+void for_each_alias(osmium::TagList const& tags,
+                    std::vector<std::string> const& alias_keys, Fn&& fn) {
+  for (auto const& key : alias_keys) {
+    auto const value = tags[key.c_str()];
+    if (value == nullptr) {
+      continue;
+    }
+
+    auto str = std::string_view(value);
+    while (!str.empty()) {
+      auto const end = std::min(str.find(';'), str.size());
+      auto alias = str.substr(0, end);
+      str.remove_prefix(std::min(end + 1, str.size()));
+
+      while (!alias.empty() && alias.front() == ' ') {
+        alias.remove_prefix(1);
+      }
+      while (!alias.empty() && alias.back() == ' ') {
+        alias.remove_suffix(1);
+      }
+      if (!alias.empty()) {
+        fn(alias);
+      }
+    }
+  }
+}
+
+// area converted by a geometry worker, the names are interned later when
+// the results of all workers are collected in input order
+struct area_geometry {
+  address_typeahead::area area_;
+  int64_t osm_id_;
+  uint64_t population_;
+  std::string name_;
+  std::vector<std::string> aliases_;
+  multi_polygon polygon_;
+};
 
 class geometry_handler : public osmium::handler::Handler {
 public:
-  explicit geometry_handler(std::vector<address_typeahead::area>& areas)
-      : areas_(areas), population_sum_(0), index_(0) {}
+  explicit geometry_handler(std::vector<std::string> const& alias_keys)
+      : alias_keys_(alias_keys) {}
 
   void area(osmium::Area const& n) {
     auto const name_tag = n.tags()["name"];
@@ -56,13 +271,10 @@ public:
 
     address_typeahead::area a{};
     auto const population_tag = n.tags()["population"];
-    if (population_tag != nullptr) {
-      auto const population = atol(population_tag);
-      a.popularity_ = static_cast<float>(population);
-      population_sum_ += population;
-    } else {
-      a.popularity_ = 0;
-    }
+    auto const population =
+        population_tag == nullptr
+            ? uint64_t(0)
+            : static_cast<uint64_t>(std::max(atol(population_tag), 0L));
 
     if (name_tag != nullptr) {
       auto const admin_level_tag = n.tags()["admin_level"];
@@ -70,12 +282,6 @@ public:
         return;
       }
 
-      auto name_it = names_.find(name_tag);
-      if (name_it == names_.end()) {
-        name_it = names_.emplace(name_tag, index_++).first;
-      }
-
-      a.name_idx_ = name_it->second;
       auto const admin_level = atol(admin_level_tag);
       if (admin_level > ADMIN_LEVEL_MAX) {
         return;
@@ -90,8 +296,6 @@ public:
         return;
       }
     }
-    areas_.emplace_back(a);
-
     multi_polygon mp;
     for (auto const& outer_ring : n.outer_rings()) {
       polygon pol;
@@ -115,242 +319,344 @@ public:
 
       mp.push_back(pol);
     }
-    polygons_.push_back(mp);
+
+    auto aliases = std::vector<std::string>();
+    if (name_tag != nullptr) {
+      for_each_alias(n.tags(), alias_keys_, [&](std::string_view const alias) {
+        if (alias != name_tag && std::find(begin(aliases), end(aliases),
+                                           alias) == end(aliases)) {
+          aliases.emplace_back(alias);
+        }
+      });
+    }
+    areas_.push_back(area_geometry{a, n.id(), population,
+                                   name_tag == nullptr ? "" : name_tag,
+                                   std::move(aliases), std::move(mp)});
+  }
+
+  std::vector<std::string> const& alias_keys_;
+  std::vector<area_geometry> areas_;
+};
+
+class area_collector {
+public:
+  area_collector(std::vector<address_typeahead::area>& areas,
+                 std::vector<int64_t>& osm_ids,
+                 std::vector<uint64_t>& population,
+                 std::vector<alias>& aliases)
+      : areas_(areas),
+        osm_ids_(osm_ids),
+        population_(population),
+        aliases_(aliases),
+        index_(0) {}
+
+  void add(geometry_handler& handler) {
+    for (auto& g : handler.areas_) {
+      if (g.area_.level_ != POSTCODE) {
+        g.area_.name_idx_ = intern(g.name_);
+        for (auto const& a : g.aliases_) {
+          aliases_.emplace_back(
+              alias{static_cast<index_t>(areas_.size()), intern(a)});
+        }
+      }
+      areas_.emplace_back(g.area_);
+      osm_ids_.emplace_back(g.osm_id_);
+      population_.emplace_back(g.population_);
+      polygons_.add(g.polygon_);
+
+      polygon_count_ += g.polygon_.size();
+      vertex_count_ += bg::num_points(g.polygon_);
+    }
+    handler.areas_.clear();
   }
 
   std::unordered_map<std::string, index_t> names_;
   std::vector<address_typeahead::area>& areas_;
-  std::vector<multi_polygon> polygons_;
+  std::vector<int64_t>& osm_ids_;
+  std::vector<uint64_t>& population_;
+  std::vector<alias>& aliases_;
+  polygon_store polygons_;
+
+  uint64_t polygon_count_{0};
+  uint64_t vertex_count_{0};
 
-  uint64_t population_sum_;
   index_t index_;
+
+private:
+  index_t intern(std::string const& name) {
+    auto name_it = names_.find(name);
+    if (name_it == names_.end()) {
+      name_it = names_.emplace(name, index_++).first;
+    }
+    return name_it->second;
+  }
 };
 
 class place_extractor : public osmium::handler::Handler {
 public:
-  explicit place_extractor(osmium::TagsFilter const& whitelist,
-                           osmium::TagsFilter const& blacklist)
-      : whitelist_(whitelist), blacklist_(blacklist), hn_index_(0) {
-    house_numbers_.emplace("", hn_index_++);
+  place_extractor(osmium::TagsFilter const& whitelist,
+                  osmium::TagsFilter const& blacklist,
+                  std::vector<std::string> const& alias_keys)
+      : whitelist_(whitelist), blacklist_(blacklist), alias_keys_(alias_keys) {
+    house_numbers_.intern("");
   }
 
   void way(osmium::Way const& w) {
-    if ((w.tags()["name"] == nullptr) || w.nodes().empty()) {
+    auto const interpolation_step = w.tags()["addr:interpolation"];
+    if (interpolation_step != nullptr) {
+      add_interpolation(w, interpolation_step);
       return;
     }
 
-    auto found_in_whitelist = false;
-    for (auto const& tag : w.tags()) {
-      if (whitelist_(tag)) {
-        found_in_whitelist = true;
-        break;
-      }
-    }
-    if (!found_in_whitelist) {
+    if ((w.tags()["name"] == nullptr) || w.nodes().empty()) {
       return;
     }
 
-    for (auto const& tag : w.tags()) {
-      if (blacklist_(tag)) {
-        return;
-      }
+    if (!matches_filters(w.tags())) {
+      return;
     }
 
-    auto const name = std::string(w.tags()["name"]);
-    if (name.length() >= 3) {
-      location loc;
-      loc.coordinates_ = {w.nodes()[0].location().x(),
-                          w.nodes()[0].location().y()};
-      loc.name_idx_ = 0;
-
-      auto const& street_it = streets_.find(name);
-      if (street_it == streets_.end()) {
-        std::vector<location> locs;
-        locs.emplace_back(loc);
-        streets_.emplace(name, locs);
-      } else {
-        street_it->second.emplace_back(loc);
-      }
+    if (add(w.tags()["name"], 0, w.nodes()[0].location())) {
+      add_aliases(w.tags());
     }
   }
 
   void node(osmium::Node const& n) {
-    auto found_in_whitelist = false;
-    for (auto const& tag : n.tags()) {
-      if (whitelist_(tag)) {
-        found_in_whitelist = true;
-        break;
-      }
-    }
-    if (!found_in_whitelist) {
+    if (!matches_filters(n.tags())) {
       return;
     }
 
-    for (auto const& tag : n.tags()) {
-      if (blacklist_(tag)) {
-        return;
-      }
+    auto const house_number = n.tags()["addr:housenumber"];
+    auto const street_name = n.tags()["addr:street"];
+    if ((house_number != nullptr) && (street_name != nullptr) &&
+        add(street_name, house_numbers_.intern(house_number), n.location())) {
+      address_nodes_.emplace_back(
+          n.id(), static_cast<uint32_t>(records_.size() - 1));
     }
 
-    location loc;
-    loc.coordinates_ = {n.location().x(), n.location().y()};
-
-    if ((n.tags()["addr:housenumber"] != nullptr) &&
-        (n.tags()["addr:street"] != nullptr)) {
+    auto const name = n.tags()["name"];
+    if (name != nullptr && add(name, 0, n.location())) {
+      add_aliases(n.tags());
+    }
+  }
 
-      auto house_number = std::string(n.tags()["addr:housenumber"]);
-      auto hn_it = house_numbers_.find(house_number);
-      if (hn_it == house_numbers_.end()) {
-        hn_it = house_numbers_.emplace(house_number, hn_index_++).first;
+  osmium::TagsFilter const& whitelist_;
+  osmium::TagsFilter const& blacklist_;
+  std::vector<std::string> const& alias_keys_;
+  string_interner names_;
+  string_interner house_numbers_;
+  std::vector<place_record> records_;
+
+  // (index into records_, alias name id), the area set of the record is
+  // assigned later
+  std::vector<std::pair<uint32_t, index_t>> aliases_;
+
+  // (index into records_ of the first address, range), filled by
+  // resolve_interpolations()
+  std::vector<std::pair<uint32_t, interpolation>> interpolations_;
+
+  // interpolation ways reference the address nodes at their ends, nodes
+  // are read before ways: the ends are matched after the pass
+  void resolve_interpolations() {
+    std::sort(begin(address_nodes_), end(address_nodes_));
+    auto const find_address = [&](osmium::object_id_type const node_id,
+                                  uint32_t& record_idx) {
+      auto const it = std::lower_bound(
+          begin(address_nodes_), end(address_nodes_), node_id,
+          [](std::pair<osmium::object_id_type, uint32_t> const& a,
+             osmium::object_id_type const id) { return a.first < id; });
+      if (it == end(address_nodes_) || it->first != node_id) {
+        return false;
       }
-      loc.name_idx_ = hn_it->second;
-
-      auto const street_name = std::string(n.tags()["addr:street"]);
-
-      if (street_name.length() >= 3) {
-        auto const& street_it = streets_.find(street_name);
-        if (street_it == streets_.end()) {
-          std::vector<location> locs;
-          locs.emplace_back(loc);
-          streets_.emplace(street_name, locs);
-        } else {
-          street_it->second.emplace_back(loc);
-        }
+      record_idx = it->second;
+      return true;
+    };
+
+    for (auto& w : interpolation_ways_) {
+      auto from = uint32_t(0);
+      auto to = uint32_t(0);
+      auto first = uint32_t(0);
+      auto last = uint32_t(0);
+      if (!find_address(w.first_node_, from) ||
+          !find_address(w.last_node_, to) ||
+          records_[from].name_idx_ != records_[to].name_idx_ ||
+          !parse_house_number(house_numbers_.get(records_[from].hn_idx_),
+                              first) ||
+          !parse_house_number(house_numbers_.get(records_[to].hn_idx_),
+                              last) ||
+          first == last) {
+        continue;
+      }
+      if (first > last) {
+        std::swap(first, last);
+        std::reverse(begin(w.polyline_), end(w.polyline_));
       }
+      interpolations_.emplace_back(
+          from, interpolation{0, first, last, w.step_, std::move(w.polyline_)});
     }
+    address_nodes_ = std::vector<std::pair<osmium::object_id_type, uint32_t>>();
+    interpolation_ways_ = std::vector<interpolation_way>();
+  }
 
-    if (n.tags()["name"] != nullptr) {
-      auto const name = std::string(n.tags()["name"]);
+private:
+  struct interpolation_way {
+    osmium::object_id_type first_node_;
+    osmium::object_id_type last_node_;
+    uint32_t step_;
+    std::vector<coordinates> polyline_;
+  };
 
-      if (name.length() >= 3) {
-        loc.name_idx_ = 0;
-        auto const& street_it = streets_.find(name);
-        if (street_it == streets_.end()) {
-          std::vector<location> locs;
-          locs.emplace_back(loc);
-          streets_.emplace(name, locs);
-        } else {
-          street_it->second.emplace_back(loc);
-        }
+  bool matches_filters(osmium::TagList const& tags) const {
+    auto found_in_whitelist = false;
+    for (auto const& tag : tags) {
+      if (whitelist_(tag)) {
+        found_in_whitelist = true;
+        break;
       }
     }
+    return found_in_whitelist && !blacklisted(tags);
   }
 
-  osmium::TagsFilter const& whitelist_;
-  osmium::TagsFilter const& blacklist_;
-  std::unordered_map<std::string, std::vector<location>> streets_;
-  std::unordered_map<std::string, index_t> house_numbers_;
-  index_t hn_index_;
-};
-
-std::vector<index_t> get_area_ids(
-    point const& p, bgi::rtree<value, bgi::linear<16>> const& rtree,
-    std::vector<multi_polygon> const& polygons) {
-  auto results = std::vector<index_t>();
-  if (rtree.empty()) {
-    return results;
+  bool blacklisted(osmium::TagList const& tags) const {
+    for (auto const& tag : tags) {
+      if (blacklist_(tag)) {
+        return true;
+      }
+    }
+    return false;
   }
 
-  auto query_list = std::vector<value>();
-  rtree.query(bgi::contains(p), std::back_inserter(query_list));
-
-  for (auto const& query_result : query_list) {
-    if (bg::within(p, polygons[query_result.second])) {
-      results.emplace_back(query_result.second);
+  // the range is stored instead of the interpolated addresses, the
+  // whitelist applies to the addresses at the ends
+  void add_interpolation(osmium::Way const& w, char const* step_value) {
+    auto step = uint32_t(0);
+    if (w.nodes().size() < 2 || !parse_interpolation_step(step_value, step) ||
+        blacklisted(w.tags())) {
+      return;
+    }
+    auto polyline = std::vector<coordinates>();
+    polyline.reserve(w.nodes().size());
+    for (auto const& n : w.nodes()) {
+      if (!n.location().valid()) {
+        return;
+      }
+      polyline.emplace_back(coordinates{n.location().x(), n.location().y()});
     }
+    interpolation_ways_.emplace_back(interpolation_way{
+        w.nodes().front().ref(), w.nodes().back().ref(), step,
+        std::move(polyline)});
   }
 
-  if (results.empty()) {
-    rtree.query(bgi::nearest(p, 1), std::back_inserter(query_list));
-    results.emplace_back(query_list[0].second);
+  bool add(char const* name, index_t const hn_idx,
+           osmium::Location const& l) {
+    auto const name_view = std::string_view(name);
+    if (name_view.length() < 3) {
+      return false;
+    }
+    records_.push_back(
+        place_record{names_.intern(name_view), hn_idx, {l.x(), l.y()}, 0});
+    return true;
   }
-  return results;
-}
 
-void remove_duplicates(typeahead_context& context,
-                       place_extractor& place_handler) {
-  for (auto& place_entry : place_handler.streets_) {
-    auto const name_idx = context.names_.size();
-    context.names_.emplace_back(place_entry.first);
-
-    std::sort(place_entry.second.begin(), place_entry.second.end());
-
-    std::map<std::vector<index_t>, std::vector<std::pair<index_t, coordinates>>>
-        places;
-    for (auto& loc : place_entry.second) {
-      std::sort(loc.areas_.begin(), loc.areas_.end());
-      auto it = places.find(loc.areas_);
-      if (it == places.end()) {
-        it = places
-                 .emplace(loc.areas_,
-                          std::vector<std::pair<index_t, coordinates>>())
-                 .first;
-      }
-      it->second.emplace_back(loc.name_idx_, loc.coordinates_);
-    }
-
-    for (auto const& unique_place : places) {
-      std::vector<house_number> house_numbers;
-      for (size_t i = 0; i != unique_place.second.size(); ++i) {
-        auto const& loc = unique_place.second[i];
-        if (loc.first == 0 && (i + 1 == unique_place.second.size())) {
-          location new_place;
-          new_place.name_idx_ = name_idx;
-          new_place.coordinates_ = loc.second;
-          new_place.areas_ = unique_place.first;
-          context.places_.emplace_back(new_place);
-        } else if (loc.first != 0) {
-          house_numbers.emplace_back(house_number{loc.first, loc.second});
-        }
-      }
-      if (!house_numbers.empty()) {
-        street new_street;
-        new_street.name_idx_ = name_idx;
-        new_street.house_numbers_ = house_numbers;
-        new_street.areas_ = unique_place.first;
-        context.streets_.emplace_back(new_street);
+  // aliases of the last record
+  void add_aliases(osmium::TagList const& tags) {
+    auto const record_idx = static_cast<uint32_t>(records_.size() - 1);
+    for_each_alias(tags, alias_keys_, [&](std::string_view const alias) {
+      if (alias.length() >= 3) {
+        aliases_.emplace_back(record_idx, names_.intern(alias));
       }
-    }
+    });
   }
-}
-
-void split_box(box const& b, int32_t const max_dim, std::vector<box>& boxes,
-               multi_polygon const& polygon) {
-  auto const min_x = b.min_corner().get<0>();
-  auto const max_x = b.max_corner().get<0>();
-  auto const min_y = b.min_corner().get<1>();
-  auto const max_y = b.max_corner().get<1>();
 
-  auto const width = max_x - min_x;
-  auto const height = max_y - min_y;
-  auto const half_width = width >> 1;
-  auto const half_height = height >> 1;
+  // (osm node id, index into records_) of the addresses
+  std::vector<std::pair<osmium::object_id_type, uint32_t>> address_nodes_;
+  std::vector<interpolation_way> interpolation_ways_;
+};
 
-  if (width <= max_dim && height <= max_dim) {
-    if (bg::covered_by(point(min_x + half_width, min_y + half_height),
-                       polygon)) {
-      boxes.emplace_back(b);
+void get_area_ids(point const& p, area_lookup const& lookup,
+                  bgi::rtree<value, bgi::linear<16>> const& rtree,
+                  std::vector<prepared_polygon> const& polygons,
+                  std::vector<index_t>& result) {
+  auto const first_result = result.size();
+  lookup.lookup(p, polygons, result);
+
+  // locations outside of all areas get the area with the nearest envelope
+  if (result.size() == first_result && !rtree.empty()) {
+    for (auto it = rtree.qbegin(bgi::nearest(p, 1)); it != rtree.qend();
+         ++it) {
+      result.push_back(it->second);
     }
-    return;
   }
+}
 
-  if (width > max_dim) {
-    auto const half_x = min_x + half_width;
-    box left_box(point(min_x, min_y), point(half_x, max_y));
-    split_box(left_box, max_dim, boxes, polygon);
+// records are processed in chunks, every chunk collects the area ids of its
+// records in one flat array
+constexpr auto const RECORDS_PER_CHUNK = size_t(4096);
+constexpr auto const CHUNKS_PER_BATCH = size_t(64);
 
-    box right_box(point(half_x + 1, min_y), point(max_x, max_y));
-    split_box(right_box, max_dim, boxes, polygon);
-  } else {
-    auto const half_y = min_y + half_height;
-    box top_box(point(min_x, half_y + 1), point(max_x, max_y));
-    split_box(top_box, max_dim, boxes, polygon);
+struct area_chunk {
+  std::vector<index_t> areas_;
+  std::vector<uint32_t> ends_;
+};
 
-    box bottom_box(point(min_x, min_y), point(max_x, half_y));
-    split_box(bottom_box, max_dim, boxes, polygon);
+void assign_areas(std::vector<place_record>& records,
+                  index_set_interner& area_sets, area_lookup const& lookup,
+                  bgi::rtree<value, bgi::linear<16>> const& rtree,
+                  std::vector<prepared_polygon> const& polygons,
+                  unsigned const num_threads,
+                  std::function<void(size_t)> const& progress) {
+  auto const num_chunks =
+      (records.size() + RECORDS_PER_CHUNK - 1) / RECORDS_PER_CHUNK;
+  auto chunks = std::vector<area_chunk>(
+      std::min(num_chunks, CHUNKS_PER_BATCH * std::max(num_threads, 1U)));
+  for (auto first_chunk = size_t(0); first_chunk < num_chunks;
+       first_chunk += chunks.size()) {
+    auto const batch_size = std::min(chunks.size(), num_chunks - first_chunk);
+    parallel_for(batch_size, num_threads, [&](size_t const i) {
+      auto& chunk = chunks[i];
+      chunk.areas_.clear();
+      chunk.ends_.clear();
+
+      auto const begin = (first_chunk + i) * RECORDS_PER_CHUNK;
+      auto const end = std::min(begin + RECORDS_PER_CHUNK, records.size());
+      for (auto r = begin; r != end; ++r) {
+        auto const& c = records[r].coordinates_;
+        get_area_ids(point(c.lon_, c.lat_), lookup, rtree, polygons,
+                     chunk.areas_);
+        chunk.ends_.push_back(static_cast<uint32_t>(chunk.areas_.size()));
+      }
+    });
+
+    // interning in record order keeps the set ids deterministic
+    for (auto i = size_t(0); i != batch_size; ++i) {
+      auto const& chunk = chunks[i];
+      auto const begin = (first_chunk + i) * RECORDS_PER_CHUNK;
+      auto set_begin = uint32_t(0);
+      for (auto j = size_t(0); j != chunk.ends_.size(); ++j) {
+        records[begin + j].area_set_ =
+            area_sets.intern(chunk.areas_.data() + set_begin,
+                             chunk.areas_.data() + chunk.ends_[j]);
+        set_begin = chunk.ends_[j];
+      }
+    }
+    progress(std::min((first_chunk + batch_size) * RECORDS_PER_CHUNK,
+                      records.size()));
   }
 }
 
+area_cache_key make_cache_key(std::string const& input_path,
+                              extract_options const& options) {
+  auto key = area_cache_key();
+  key.input_path_ = std::filesystem::absolute(input_path).string();
+  key.input_size_ = std::filesystem::file_size(input_path);
+  key.input_mtime_ =
+      std::filesystem::last_write_time(input_path).time_since_epoch().count();
+  key.approximation_lvl_ = options.approximation_lvl_;
+  key.simplify_tolerance_ = options.simplify_tolerance_;
+  key.alias_keys_ = options.alias_keys_;
+  return key;
+}
+
 void extract_options::whitelist_add(std::string const& tag,
                                     std::string const& value) {
   if (value.empty()) {
@@ -371,6 +677,17 @@ void extract_options::blacklist_add(std::string const& tag,
 
 typeahead_context extract(std::string const& input_path,
                           extract_options const& options) {
+  extract_report report;
+  return extract(input_path, options, report);
+}
+
+typeahead_context extract(std::string const& input_path,
+                          extract_options const& options,
+                          extract_report& report) {
+  report.input_path_ = input_path;
+  report.approximation_lvl_ = options.approximation_lvl_;
+  report.location_index_ = to_str(options.location_index_);
+
   auto progress_tracker =
       utl::get_active_progress_tracker_or_activate("address");
   progress_tracker->show_progress(true);
@@ -388,12 +705,27 @@ typeahead_context extract(std::string const& input_path,
   osmium::area::MultipolygonManager<osmium::area::Assembler> mp_manager(
       assembler_config, mp_filter);
 
+  // areas of a previous extraction with the same input and area options
+  // are reused, only node locations and places are read again
+  // the key is only built with a cache, inputs like stdin have no file size
+  auto cache = area_cache();
+  auto cache_key = area_cache_key();
+  auto cached = false;
+  if (!options.area_cache_path_.empty()) {
+    cache_key = make_cache_key(input_path, options);
+    cached = read_area_cache(options.area_cache_path_, cache_key, cache);
+  }
+  report.area_cache_hit_ = cached;
+
   // first pass : read relations
-  progress_tracker->status("1st Pass / Relations").out_bounds(0.F, 25.F);
-  osmium::relations::read_relations(input_file, mp_manager);
+  if (!cached) {
+    progress_tracker->status("1st Pass / Relations").out_bounds(0.F, 25.F);
+    report.start_stage("relations");
+    osmium::relations::read_relations(input_file, mp_manager);
+  }
 
-  index_type index;
-  location_handler_type location_handler(index);
+  auto index = location_index(options);
+  location_handler_type location_handler(*index.index_);
   location_handler.ignore_errors();
 
   // second pass : read all objects & run them first through the node location
@@ -404,91 +736,269 @@ typeahead_context extract(std::string const& input_path,
   progress_tracker->status("2nd Pass / Geometry")
       .out_bounds(25.F, 50.F)
       .in_high(reader.file_size());
+  report.start_stage("node_locations_and_areas");
   typeahead_context context;
-  auto geom_handler = geometry_handler(context.areas_);
-  auto place_handler = place_extractor(options.whitelist_, options.blacklist_);
-  osmium::apply(
-      reader, [&](auto&&) { progress_tracker->update(reader.offset()); },
-      location_handler,
-      mp_manager.handler([&geom_handler](osmium::memory::Buffer&& buffer) {
-        osmium::apply(buffer, geom_handler);
-      }),
-      place_handler);
-  reader.close();
+  auto geom_handler =
+      area_collector(context.areas_, context.area_osm_ids_,
+                     context.area_population_, context.area_aliases_);
+  auto place_handler = place_extractor(options.whitelist_, options.blacklist_,
+                                       options.alias_keys_);
+  {
+    // the calling thread resolves node locations and assembles areas, the
+    // buffers are then handed to the place extractor thread, assembled areas
+    // are converted by the geometry workers
+    auto place_queue = bounded_queue<osmium::memory::Buffer>(QUEUE_CAPACITY);
+    auto area_queue = bounded_queue<std::pair<size_t, osmium::memory::Buffer>>(
+        QUEUE_CAPACITY);
+
+    // converted buffers are collected in assembly order as soon as all
+    // previous buffers are done, so only few full resolution geometries are
+    // alive at the same time
+    std::mutex converted_mutex;
+    auto converted = std::map<size_t, geometry_handler>();
+    auto next_converted = size_t(0);
+
+    auto workers = pipeline_workers();
+    workers.run([&]() {
+      consume(place_queue, [&](osmium::memory::Buffer& buffer) {
+        osmium::apply(buffer, place_handler);
+      });
+    });
+    auto const geometry_workers =
+        cached ? 0U : std::max(options.num_threads_, 3U) - 2U;
+    for (auto i = 0U; i != geometry_workers; ++i) {
+      workers.run([&]() {
+        consume(area_queue,
+                [&](std::pair<size_t, osmium::memory::Buffer>& areas) {
+                  auto handler = geometry_handler(options.alias_keys_);
+                  osmium::apply(areas.second, handler);
+
+                  std::lock_guard<std::mutex> lock(converted_mutex);
+                  converted.emplace(areas.first, std::move(handler));
+                  for (auto it = converted.find(next_converted);
+                       it != end(converted);
+                       it = converted.find(++next_converted)) {
+                    geom_handler.add(it->second);
+                    converted.erase(it);
+                  }
+                });
+      });
+    }
 
-  auto const inv_population_sum =
-      1.0 / static_cast<double>(geom_handler.population_sum_);
-  for (auto& area : context.areas_) {
-    area.popularity_ = 1.0 + area.popularity_ * inv_population_sum;
+    auto area_buffer_idx = size_t(0);
+    auto mp_handler =
+        mp_manager.handler([&](osmium::memory::Buffer&& buffer) {
+          area_queue.push(std::make_pair(area_buffer_idx++, std::move(buffer)));
+        });
+    try {
+      while (auto buffer = reader.read()) {
+        progress_tracker->update(reader.offset());
+        if (cached) {
+          osmium::apply(buffer, location_handler);
+        } else {
+          osmium::apply(buffer, location_handler, mp_handler);
+        }
+        place_queue.push(std::move(buffer));
+      }
+    } catch (...) {
+      place_queue.close();
+      area_queue.close();
+      workers.join();
+      throw;
+    }
+    place_queue.close();
+    area_queue.close();
+    workers.join();
   }
-
-  std::vector<value> values;
-  for (index_t i = 0; i != geom_handler.polygons_.size(); ++i) {
-    auto b = bg::return_envelope<box>(geom_handler.polygons_[i]);
-    assert(b.min_corner().get<0>() <= b.max_corner().get<0>());
-    assert(b.min_corner().get<1>() <= b.max_corner().get<1>());
-    values.emplace_back(b, i);
+  reader.close();
+  index.release();
+  place_handler.resolve_interpolations();
+
+  // APPROX_LVL_* select the cell size of an approximate lookup, which
+  // resolves cells crossed by a boundary by their centre and does not need
+  // the polygons afterwards
+  auto lookup_options = area_lookup_options();
+  if (options.approximation_lvl_ != APPROX_NONE) {
+    lookup_options.exact_ = false;
+    lookup_options.min_cell_size_ =
+        static_cast<int32_t>(options.approximation_lvl_);
   }
 
-  std::vector<value> final_values;
-  if (options.approximation_lvl_ < APPROX_LVL_1 ||
-      options.approximation_lvl_ > APPROX_LVL_5) {
-    final_values.insert(final_values.end(), values.begin(), values.end());
+  auto prepared_polygons = std::vector<prepared_polygon>();
+  auto lookup = area_lookup();
+  if (cached) {
+    context.areas_ = std::move(cache.areas_);
+    context.area_names_ = std::move(cache.area_names_);
+    context.area_aliases_ = std::move(cache.area_aliases_);
+    context.area_osm_ids_ = std::move(cache.area_osm_ids_);
+    context.area_population_ = std::move(cache.area_population_);
+    prepared_polygons = std::move(cache.polygons_);
+    lookup = std::move(cache.lookup_);
   } else {
-    progress_tracker->status("Approximate Polygons")
-        .out_bounds(50.F, 75.F)
-        .in_high(values.size());
-
-    auto const max_dim = options.approximation_lvl_;
-    for (index_t i = 0; i != values.size(); ++i) {
-      progress_tracker->increment();
-      std::vector<box> split_boxes;
-      split_box(values[i].first, max_dim, split_boxes,
-                geom_handler.polygons_[i]);
-      for (auto const& b : split_boxes) {
-        final_values.emplace_back(b, i);
+    context.area_names_.resize(geom_handler.names_.size());
+    for (auto const& area_name : geom_handler.names_) {
+      context.area_names_[area_name.second] = area_name.first;
+    }
+
+    report.polygons_ = geom_handler.polygon_count_;
+    report.polygon_vertices_ = geom_handler.vertex_count_;
+    // shared boundaries are simplified once for all areas using them
+    if (options.simplify_tolerance_ > 0) {
+      progress_tracker->status("Simplify Polygons");
+      report.start_stage("simplify_polygons");
+      geom_handler.polygons_.simplify(options.simplify_tolerance_);
+    }
+    report.polygon_store_bytes_ = geom_handler.polygons_.byte_size();
+
+    progress_tracker->status("Prepare Polygons")
+        .out_bounds(50.F, 65.F)
+        .in_high(geom_handler.polygons_.size());
+    report.start_stage("prepare_polygons");
+
+    std::mutex prepare_mutex;
+    if (lookup_options.exact_) {
+      prepared_polygons.resize(geom_handler.polygons_.size());
+      parallel_for(prepared_polygons.size(), options.num_threads_,
+                   [&](size_t const i) {
+                     prepared_polygons[i] =
+                         prepared_polygon(geom_handler.polygons_.get(i));
+
+                     std::lock_guard<std::mutex> lock(prepare_mutex);
+                     progress_tracker->increment();
+                   });
+
+      geom_handler.polygons_ = polygon_store();
+
+      progress_tracker->status("Build Area Lookup").out_bounds(65.F, 75.F);
+      report.start_stage("build_area_lookup");
+      lookup = area_lookup(prepared_polygons, lookup_options);
+    } else {
+      // approximate lookups never use the polygons: every polygon is
+      // prepared, added to the lookup and released right away
+      auto bounds = box();
+      auto envelope = box();
+      bg::assign_inverse(bounds);
+      for (index_t i = 0; i != geom_handler.polygons_.size(); ++i) {
+        if (geom_handler.polygons_.envelope(i, envelope)) {
+          bg::expand(bounds, envelope);
+        }
       }
+
+      auto builder = area_lookup::approximate_builder(bounds, lookup_options);
+      parallel_for(geom_handler.polygons_.size(), options.num_threads_,
+                   [&](size_t const i) {
+                     auto const pol =
+                         prepared_polygon(geom_handler.polygons_.get(i));
+
+                     std::lock_guard<std::mutex> lock(prepare_mutex);
+                     builder.add(static_cast<index_t>(i), pol);
+                     progress_tracker->increment();
+                   });
+
+      geom_handler.polygons_ = polygon_store();
+
+      progress_tracker->status("Build Area Lookup").out_bounds(65.F, 75.F);
+      report.start_stage("build_area_lookup");
+      lookup = builder.finish();
     }
-  }
 
-  auto rtree = bgi::rtree<value, bgi::linear<16>>();
-  rtree.insert(final_values.begin(), final_values.end());
+    if (!options.area_cache_path_.empty()) {
+      report.start_stage("write_area_cache");
+      cache.key_ = cache_key;
+      cache.areas_ = context.areas_;
+      cache.area_names_ = context.area_names_;
+      cache.area_aliases_ = context.area_aliases_;
+      cache.area_osm_ids_ = context.area_osm_ids_;
+      cache.area_population_ = context.area_population_;
+      cache.polygons_ = std::move(prepared_polygons);
+      cache.lookup_ = std::move(lookup);
+      write_area_cache(options.area_cache_path_, cache);
+      prepared_polygons = std::move(cache.polygons_);
+      lookup = std::move(cache.lookup_);
+      cache = area_cache();
+    }
+  }
+  report.areas_ = context.areas_.size();
+  report.lookup_cells_ = lookup.cells_.size();
+  report.area_sets_ = lookup.set_offsets_.size() - 1;
+
+  // exact mode assigns the area with the nearest envelope to locations
+  // outside of all areas, constructing the rtree from the whole range uses
+  // bulk loading (packing)
+  report.start_stage("build_rtree");
+  auto values = std::vector<value>();
+  for (index_t i = 0; i != prepared_polygons.size(); ++i) {
+    if (!prepared_polygons[i].strip_edges_.empty()) {
+      values.emplace_back(prepared_polygons[i].envelope_, i);
+    }
+  }
+  report.rtree_values_ = values.size();
+  auto const rtree = bgi::rtree<value, bgi::linear<16>>(values);
 
   progress_tracker->status("Generate Streets")
       .out_bounds(75.F, 100.F)
-      .in_high(place_handler.streets_.size());
-
-  for (auto& str_it : place_handler.streets_) {
-    progress_tracker->increment();
-    for (auto& loc : str_it.second) {
-      auto const p = point(loc.coordinates_.lon_, loc.coordinates_.lat_);
-      if (options.approximation_lvl_ == APPROX_NONE) {
-        loc.areas_ = get_area_ids(p, rtree, geom_handler.polygons_);
-      } else {
-        auto query_list = std::vector<value>();
-        rtree.query(bgi::covers(p), std::back_inserter(query_list));
-        for (auto const& q : query_list) {
-          loc.areas_.emplace_back(q.second);
-        }
-      }
-    }
+      .in_high(place_handler.records_.size());
+  report.start_stage("assign_areas");
+  report.locations_ = place_handler.records_.size();
+
+  auto area_sets = index_set_interner();
+  assign_areas(place_handler.records_, area_sets, lookup, rtree,
+               prepared_polygons, options.num_threads_,
+               [&](size_t const done) { progress_tracker->update(done); });
+
+  auto aliases = std::vector<alias_record>();
+  aliases.reserve(place_handler.aliases_.size());
+  for (auto const& [record_idx, alias_idx] : place_handler.aliases_) {
+    auto const& r = place_handler.records_[record_idx];
+    aliases.emplace_back(alias_record{r.name_idx_, r.area_set_, alias_idx});
+  }
+  place_handler.aliases_ = std::vector<std::pair<uint32_t, index_t>>();
+
+  auto interpolations = std::vector<interpolation_record>();
+  interpolations.reserve(place_handler.interpolations_.size());
+  for (auto& [record_idx, i] : place_handler.interpolations_) {
+    auto const& r = place_handler.records_[record_idx];
+    interpolations.emplace_back(
+        interpolation_record{r.name_idx_, r.area_set_, std::move(i)});
   }
+  place_handler.interpolations_ =
+      std::vector<std::pair<uint32_t, interpolation>>();
 
   progress_tracker->status("Removing Duplicates");
-  remove_duplicates(context, place_handler);
+  report.start_stage("remove_duplicates");
+  canonicalize(context, place_handler.records_, aliases, interpolations,
+               place_handler.names_, place_handler.house_numbers_, area_sets);
+  remove_duplicates(context, place_handler.records_, std::move(aliases),
+                    std::move(interpolations), place_handler.names_,
+                    area_sets, options.num_threads_);
+  place_handler.records_ = std::vector<place_record>();
 
-  progress_tracker->status("FINISHED").show_progress(false);
+  report.start_stage("finalize");
 
-  context.area_names_.resize(geom_handler.names_.size());
-  for (auto const& area_name : geom_handler.names_) {
-    context.area_names_[area_name.second] = area_name.first;
+  context.house_numbers_.resize(place_handler.house_numbers_.size());
+  for (auto i = size_t(0); i != context.house_numbers_.size(); ++i) {
+    context.house_numbers_[i] =
+        std::string(place_handler.house_numbers_.get(static_cast<index_t>(i)));
+  }
+  add_search_keys(context, options.num_threads_);
+  add_importance(context, options.num_threads_);
+  if (options.labels_) {
+    add_labels(context, options.num_threads_);
   }
 
-  context.house_numbers_.resize(place_handler.house_numbers_.size());
-  for (auto const& hn : place_handler.house_numbers_) {
-    context.house_numbers_[hn.second] = hn.first;
+  report.finish_stage();
+  report.places_ = context.places_.size();
+  report.streets_ = context.streets_.size();
+  report.house_numbers_ = 0;
+  for (auto const& str : context.streets_) {
+    report.house_numbers_ += str.house_numbers_.size();
   }
+  report.interpolations_ = context.interpolations_.size();
+  report.names_ = context.names_.size();
+  report.area_names_ = context.area_names_.size();
+  report.house_number_names_ = context.house_numbers_.size();
 
+  progress_tracker->status("FINISHED").show_progress(false);
   return context;
 }
 
@@ -0,0 +1,167 @@
+#include "address-typeahead/house_number_index.h"
+
+#include <algorithm>
+#include <numeric>
+
+#include "address-typeahead/interpolation.h"
+
+namespace address_typeahead {
+
+std::string house_number_key(std::string_view const house_number) {
+  auto key = std::string();
+  key.reserve(house_number.size());
+  for (auto const c : house_number) {
+    if (c == ' ') {
+      continue;
+    }
+    key.push_back((c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a')
+                                         : c);
+  }
+  return key;
+}
+
+bool natural_less(std::string_view const a, std::string_view const b) {
+  auto const digits = [](std::string_view const str) {
+    auto n = size_t(0);
+    while (n != str.size() && str[n] >= '0' && str[n] <= '9') {
+      ++n;
+    }
+    return n;
+  };
+
+  auto const a_digits = digits(a);
+  auto const b_digits = digits(b);
+  if ((a_digits == 0) != (b_digits == 0)) {
+    return a_digits != 0;
+  }
+
+  // compare numbers without parsing: strip leading zeros, the longer number
+  // is larger, numbers of the same length compare lexicographically
+  auto const a_num = a.substr(0, a_digits);
+  auto const b_num = b.substr(0, b_digits);
+  auto const a_value = a_num.substr(std::min(a_num.find_first_not_of('0'),
+                                             a_num.size()));
+  auto const b_value = b_num.substr(std::min(b_num.find_first_not_of('0'),
+                                             b_num.size()));
+  if (a_value.size() != b_value.size()) {
+    return a_value.size() < b_value.size();
+  }
+  if (a_value != b_value) {
+    return a_value < b_value;
+  }
+  if (a.substr(a_digits) != b.substr(b_digits)) {
+    return a.substr(a_digits) < b.substr(b_digits);
+  }
+  return a < b;
+}
+
+house_number_index::house_number_index(typeahead_context const& context) {
+  keys_.reserve(context.house_numbers_.size());
+  for (auto const& hn : context.house_numbers_) {
+    keys_.emplace_back(house_number_key(hn));
+  }
+
+  offsets_.reserve(context.streets_.size() + 1);
+  offsets_.emplace_back(0);
+  for (auto const& s : context.streets_) {
+    auto const first = sorted_.size();
+    sorted_.resize(first + s.house_numbers_.size());
+    std::iota(begin(sorted_) + first, end(sorted_), 0U);
+    std::sort(begin(sorted_) + first, end(sorted_),
+              [&](uint32_t const a, uint32_t const b) {
+                auto const& key_a = keys_[s.house_numbers_[a].hn_idx_];
+                auto const& key_b = keys_[s.house_numbers_[b].hn_idx_];
+                return key_a < key_b || (key_a == key_b && a < b);
+              });
+    offsets_.emplace_back(sorted_.size());
+  }
+}
+
+std::vector<house_number_match> house_number_index::match(
+    typeahead_context const& context, index_t const street_idx,
+    std::string_view const prefix, size_t const max_results) const {
+  auto const& house_numbers = context.streets_[street_idx].house_numbers_;
+  auto const key_of = [&](uint32_t const position) -> std::string const& {
+    return keys_[house_numbers[position].hn_idx_];
+  };
+
+  auto const prefix_key = house_number_key(prefix);
+  auto const first = begin(sorted_) + offsets_[street_idx];
+  auto const last = begin(sorted_) + offsets_[street_idx + 1];
+  auto const by_key = [&](uint32_t const position, std::string const& key) {
+    return key_of(position) < key;
+  };
+  auto it = std::lower_bound(first, last, prefix_key, by_key);
+
+  auto matches = std::vector<uint32_t>();
+  for (; it != last; ++it) {
+    auto const& key = key_of(*it);
+    if (key.compare(0, prefix_key.size(), prefix_key) != 0) {
+      break;
+    }
+    if (matches.empty() || key_of(matches.back()) != key) {
+      matches.emplace_back(*it);
+    }
+  }
+
+  // interpolated numbers starting with the prefix, unless mapped
+  auto const is_mapped = [&](std::string const& key) {
+    auto const pos = std::lower_bound(first, last, key, by_key);
+    return pos != last && key_of(*pos) == key;
+  };
+  auto const id = static_cast<index_t>(context.places_.size() + street_idx);
+  auto interpolated = std::vector<std::pair<std::string, coordinates>>();
+  for (auto i = std::lower_bound(begin(context.interpolations_),
+                                 end(context.interpolations_), id,
+                                 [](interpolation const& a, index_t const b) {
+                                   return a.id_ < b;
+                                 });
+       i != end(context.interpolations_) && i->id_ == id; ++i) {
+    for_each_number(*i, [&](uint32_t const number) {
+      auto key = std::to_string(number);
+      auto c = coordinates();
+      if (key.compare(0, prefix_key.size(), prefix_key) == 0 &&
+          !is_mapped(key) && interpolate(*i, number, c)) {
+        interpolated.emplace_back(std::move(key), c);
+      }
+    });
+  }
+  std::sort(begin(interpolated), end(interpolated),
+            [](auto const& a, auto const& b) { return a.first < b.first; });
+  interpolated.erase(std::unique(begin(interpolated), end(interpolated),
+                                 [](auto const& a, auto const& b) {
+                                   return a.first == b.first;
+                                 }),
+                     end(interpolated));
+
+  // candidates < matches.size() are mapped, the others interpolated
+  auto candidates = std::vector<size_t>(matches.size() + interpolated.size());
+  std::iota(begin(candidates), end(candidates), size_t(0));
+  auto const candidate_key = [&](size_t const c) -> std::string const& {
+    return c < matches.size() ? key_of(matches[c])
+                              : interpolated[c - matches.size()].first;
+  };
+
+  auto const n = std::min(max_results, candidates.size());
+  std::partial_sort(begin(candidates), begin(candidates) + n, end(candidates),
+                    [&](size_t const a, size_t const b) {
+                      return natural_less(candidate_key(a), candidate_key(b));
+                    });
+
+  auto result = std::vector<house_number_match>();
+  result.reserve(n);
+  for (auto i = size_t(0); i != n; ++i) {
+    auto const c = candidates[i];
+    if (c < matches.size()) {
+      auto const& hn = house_numbers[matches[c]];
+      result.emplace_back(house_number_match{
+          context.house_numbers_[hn.hn_idx_], hn.coordinates_, false});
+    } else {
+      auto& [key, coords] = interpolated[c - matches.size()];
+      result.emplace_back(house_number_match{std::move(key), coords, true});
+    }
+  }
+  return result;
+}
+
+}  // namespace address_typeahead
@@ -0,0 +1,45 @@
+#include "address-typeahead/importance.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace address_typeahead {
+
+constexpr auto const AREA_WEIGHT = 0.5F;
+constexpr auto const HOUSE_NUMBER_WEIGHT = 0.02F;
+constexpr auto const MAX_HOUSE_NUMBER_BONUS = 0.2F;
+
+float get_importance(typeahead_context const& context, index_t const id) {
+  auto const& area_ids = context.is_place(id)
+                             ? context.places_[id].areas_
+                             : context.streets_[id - context.places_.size()]
+                                   .areas_;
+
+  // popularity_ is 1 + population / population sum
+  auto population_share = 0.0F;
+  for (auto const area_id : area_ids) {
+    auto const& a = context.areas_[area_id];
+    if (a.level_ != POSTCODE) {
+      population_share = std::max(population_share, a.popularity_ - 1.0F);
+    }
+  }
+
+  auto importance = 1.0F + AREA_WEIGHT * std::min(population_share, 1.0F);
+  if (context.is_street(id)) {
+    auto const house_numbers = static_cast<float>(
+        context.streets_[id - context.places_.size()].house_numbers_.size());
+    importance +=
+        std::min(MAX_HOUSE_NUMBER_BONUS,
+                 HOUSE_NUMBER_WEIGHT * std::log2(1.0F + house_numbers));
+  }
+  return importance;
+}
+
+void add_importance(typeahead_context& context, unsigned const num_threads) {
+  context.importance_.resize(context.places_.size() + context.streets_.size());
+  parallel_for(context.importance_.size(), num_threads, [&](size_t const i) {
+    context.importance_[i] = get_importance(context, static_cast<index_t>(i));
+  });
+}
+
+}  // namespace address_typeahead
@@ -0,0 +1,68 @@
+#include "address-typeahead/interner.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace address_typeahead {
+
+constexpr auto const BLOCK_SIZE = size_t(1) << 20U;
+
+index_t string_interner::intern(std::string_view const str) {
+  auto const it = ids_.find(str);
+  if (it != ids_.end()) {
+    return it->second;
+  }
+
+  auto const id = static_cast<index_t>(strings_.size());
+  auto const stored = store(str);
+  strings_.push_back(stored);
+  ids_.emplace(stored, id);
+  return id;
+}
+
+std::string_view string_interner::store(std::string_view const str) {
+  if (str.empty()) {
+    return std::string_view();
+  }
+
+  if (block_used_ + str.size() > block_size_) {
+    block_size_ = std::max(BLOCK_SIZE, str.size());
+    blocks_.emplace_back(new char[block_size_]);
+    block_used_ = 0;
+  }
+
+  auto const data = blocks_.back().get() + block_used_;
+  std::memcpy(data, str.data(), str.size());
+  block_used_ += str.size();
+  return std::string_view(data, str.size());
+}
+
+index_set_interner::index_set_interner() { intern(nullptr, nullptr); }
+
+index_t index_set_interner::intern(index_t const* begin, index_t const* end) {
+  auto h = uint64_t(14695981039346656037ULL);
+  for (auto it = begin; it != end; ++it) {
+    h = (h ^ *it) * 1099511628211ULL;
+  }
+
+  auto& candidates = index_[h];
+  for (auto const candidate : candidates) {
+    if (std::equal(data_.begin() + offsets_[candidate],
+                   data_.begin() + offsets_[candidate + 1], begin, end)) {
+      return candidate;
+    }
+  }
+
+  auto const id = static_cast<index_t>(size());
+  data_.insert(data_.end(), begin, end);
+  offsets_.push_back(data_.size());
+  candidates.push_back(id);
+  return id;
+}
+
+std::vector<index_t> index_set_interner::get(index_t const id) const {
+  return std::vector<index_t>(data_.begin() + offsets_[id],
+                              data_.begin() + offsets_[id + 1]);
+}
+
+}  // namespace address_typeahead
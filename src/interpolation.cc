@@ -0,0 +1,83 @@
+#include "address-typeahead/interpolation.h"
+
+#include <cmath>
+
+namespace address_typeahead {
+
+namespace {
+
+constexpr auto const TO_RAD = 3.14159265358979323846 / 180.0;
+
+}  // namespace
+
+bool parse_house_number(std::string_view const str, uint32_t& number) {
+  if (str.empty() || str.size() > 9) {
+    return false;
+  }
+  number = 0;
+  for (auto const c : str) {
+    if (c < '0' || c > '9') {
+      return false;
+    }
+    number = number * 10 + static_cast<uint32_t>(c - '0');
+  }
+  return true;
+}
+
+bool parse_interpolation_step(std::string_view const value, uint32_t& step) {
+  if (value == "all") {
+    step = 1;
+  } else if (value == "odd" || value == "even") {
+    step = 2;
+  } else if (!parse_house_number(value, step)) {
+    return false;
+  }
+  return step != 0;
+}
+
+bool interpolate(interpolation const& i, uint32_t const number,
+                 coordinates& result) {
+  if (i.step_ == 0 || number < i.first_ || number > i.last_ ||
+      i.polyline_.empty() || (number - i.first_) % i.step_ != 0) {
+    return false;
+  }
+
+  // segment lengths in degrees with the longitude scaled to the latitude
+  auto const& line = i.polyline_;
+  auto const scale = std::cos(line.front().lat_ / 10000000.0 * TO_RAD);
+  auto const segment_length = [&](size_t const s) {
+    auto const& a = line[s];
+    auto const& b = line[s + 1];
+    return std::hypot((static_cast<double>(b.lon_) - a.lon_) * scale,
+                      static_cast<double>(b.lat_) - a.lat_);
+  };
+
+  auto length = 0.0;
+  for (auto s = size_t(0); s + 1 < line.size(); ++s) {
+    length += segment_length(s);
+  }
+
+  auto const fraction =
+      i.last_ == i.first_ ? 0.0
+                          : static_cast<double>(number - i.first_) /
+                                static_cast<double>(i.last_ - i.first_);
+  auto remaining = fraction * length;
+  for (auto s = size_t(0); s + 1 < line.size(); ++s) {
+    auto const l = segment_length(s);
+    if (remaining <= l && l > 0.0) {
+      auto const t = remaining / l;
+      auto const& a = line[s];
+      auto const& b = line[s + 1];
+      result.lon_ = static_cast<int32_t>(
+          std::lround(a.lon_ + t * (static_cast<double>(b.lon_) - a.lon_)));
+      result.lat_ = static_cast<int32_t>(
+          std::lround(a.lat_ + t * (static_cast<double>(b.lat_) - a.lat_)));
+      return true;
+    }
+    remaining -= l;
+  }
+  result = line.back();
+  return true;
+}
+
+}  // namespace address_typeahead
@@ -0,0 +1,68 @@
+#include "address-typeahead/labels.h"
+
+#include <map>
+#include <vector>
+
+#include "address-typeahead/interner.h"
+
+namespace address_typeahead {
+
+std::string get_area_label(typeahead_context const& context,
+                           index_t const id) {
+  auto label = std::string();
+  for (auto const& [name, admin_level] : context.get_area_names(id)) {
+    if (!label.empty()) {
+      label += ", ";
+    }
+    label += name;
+  }
+  return label;
+}
+
+void add_labels(typeahead_context& context, unsigned const num_threads) {
+  auto const num_entities = context.places_.size() + context.streets_.size();
+
+  // entities with the same areas share the label, it is computed once per
+  // distinct area list
+  auto area_lists = std::map<std::vector<index_t>, index_t>();
+  auto representatives = std::vector<index_t>();
+  auto list_of = std::vector<index_t>(num_entities);
+  for (auto i = size_t(0); i != num_entities; ++i) {
+    auto const id = static_cast<index_t>(i);
+    auto const& areas = context.is_place(id)
+                            ? context.places_[i].areas_
+                            : context.streets_[i - context.places_.size()]
+                                  .areas_;
+    auto const [it, inserted] = area_lists.emplace(
+        areas, static_cast<index_t>(representatives.size()));
+    if (inserted) {
+      representatives.emplace_back(id);
+    }
+    list_of[i] = it->second;
+  }
+
+  auto labels = std::vector<std::string>(representatives.size());
+  parallel_for(representatives.size(), num_threads, [&](size_t const i) {
+    labels[i] = get_area_label(context, representatives[i]);
+  });
+
+  // different area lists (e.g. differing in duplicate names) may have the
+  // same label
+  auto interner = string_interner();
+  auto label_of_list = std::vector<index_t>(labels.size());
+  for (auto i = size_t(0); i != labels.size(); ++i) {
+    label_of_list[i] = interner.intern(labels[i]);
+  }
+
+  context.area_labels_.resize(interner.size());
+  for (auto i = size_t(0); i != interner.size(); ++i) {
+    context.area_labels_[i] =
+        std::string(interner.get(static_cast<index_t>(i)));
+  }
+  context.label_areas_.resize(num_entities);
+  for (auto i = size_t(0); i != num_entities; ++i) {
+    context.label_areas_[i] = label_of_list[list_of[i]];
+  }
+}
+
+}  // namespace address_typeahead
@@ -0,0 +1,39 @@
+#include "address-typeahead/memory_report.h"
+
+namespace address_typeahead {
+
+size_t heap_bytes(std::string const& str) {
+  // short strings are stored inline
+  static auto const inline_capacity = std::string().capacity();
+  return str.capacity() > inline_capacity ? str.capacity() + 1 : 0;
+}
+
+void memory_report::add(std::string name, uint64_t const bytes) {
+  components_.emplace_back(std::move(name), bytes);
+}
+
+void memory_report::add(std::string const& prefix,
+                        memory_report const& other) {
+  for (auto const& [name, bytes] : other.components_) {
+    components_.emplace_back(prefix + name, bytes);
+  }
+}
+
+uint64_t memory_report::total() const {
+  auto total = uint64_t(0);
+  for (auto const& [name, bytes] : components_) {
+    total += bytes;
+  }
+  return total;
+}
+
+void memory_report::write_json(std::ostream& out) const {
+  out << "{\n  \"total_bytes\": " << total() << ",\n  \"components\": {";
+  for (size_t i = 0; i != components_.size(); ++i) {
+    out << (i == 0 ? "\n" : ",\n") << "    \"" << components_[i].first
+        << "\": " << components_[i].second;
+  }
+  out << "\n  }\n}\n";
+}
+
+}  // namespace address_typeahead
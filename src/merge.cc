@@ -0,0 +1,215 @@
+#include "address-typeahead/merge.h"
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+#include "address-typeahead/importance.h"
+#include "address-typeahead/interner.h"
+#include "address-typeahead/labels.h"
+#include "address-typeahead/normalize.h"
+#include "address-typeahead/place_records.h"
+
+namespace address_typeahead {
+
+namespace {
+
+// contexts without area_population_: popularity_ is
+// 1 + population / population_sum_
+uint64_t population_of(typeahead_context const& c, size_t const area_idx) {
+  if (c.area_population_.size() == c.areas_.size()) {
+    return c.area_population_[area_idx];
+  }
+  auto const population = (c.areas_[area_idx].popularity_ - 1.0) *
+                          static_cast<double>(c.population_sum_);
+  return static_cast<uint64_t>(std::llround(std::max(population, 0.0)));
+}
+
+std::vector<index_t> merge_areas(typeahead_context const& c,
+                                 typeahead_context& merged,
+                                 string_interner& area_names,
+                                 std::vector<alias>& area_aliases,
+                                 std::unordered_map<int64_t, index_t>& by_id,
+                                 std::map<std::pair<uint32_t, std::string>,
+                                          index_t>& by_name) {
+  auto const has_ids = c.area_osm_ids_.size() == c.areas_.size();
+  auto area_map = std::vector<index_t>(c.areas_.size());
+  for (auto i = size_t(0); i != c.areas_.size(); ++i) {
+    auto const& a = c.areas_[i];
+    auto const name = a.level_ == POSTCODE ? std::to_string(a.name_idx_)
+                                           : c.area_names_[a.name_idx_];
+    auto const next_idx = static_cast<index_t>(merged.areas_.size());
+    auto inserted = false;
+    if (has_ids) {
+      auto const [it, added] = by_id.emplace(c.area_osm_ids_[i], next_idx);
+      area_map[i] = it->second;
+      inserted = added;
+    } else {
+      auto const [it, added] =
+          by_name.emplace(std::make_pair(a.level_, name), next_idx);
+      area_map[i] = it->second;
+      inserted = added;
+    }
+
+    auto const first_alias = std::lower_bound(
+        begin(c.area_aliases_), end(c.area_aliases_), i,
+        [](alias const& other, size_t const id) { return other.id_ < id; });
+    for (auto it = first_alias; it != end(c.area_aliases_) && it->id_ == i;
+         ++it) {
+      area_aliases.emplace_back(
+          alias{area_map[i], area_names.intern(c.area_names_[it->name_idx_])});
+    }
+
+    if (!inserted) {
+      continue;
+    }
+
+    auto merged_area = a;
+    if (a.level_ != POSTCODE) {
+      merged_area.name_idx_ = area_names.intern(name);
+    }
+    merged.areas_.emplace_back(merged_area);
+    merged.area_osm_ids_.emplace_back(has_ids ? c.area_osm_ids_[i] : 0);
+
+    merged.area_population_.emplace_back(population_of(c, i));
+  }
+  return area_map;
+}
+
+}  // namespace
+
+typeahead_context merge(std::vector<typeahead_context> const& contexts,
+                        unsigned const num_threads) {
+  typeahead_context merged;
+
+  auto area_names = string_interner();
+  auto area_aliases = std::vector<alias>();
+  auto by_id = std::unordered_map<int64_t, index_t>();
+  auto by_name = std::map<std::pair<uint32_t, std::string>, index_t>();
+
+  auto names = string_interner();
+  auto house_numbers = string_interner();
+  house_numbers.intern("");
+  auto area_sets = index_set_interner();
+  auto records = std::vector<place_record>();
+  auto aliases = std::vector<alias_record>();
+  auto interpolations = std::vector<interpolation_record>();
+
+  auto all_ids = true;
+  auto any_labels = false;
+  auto set_areas = std::vector<index_t>();
+  for (auto const& c : contexts) {
+    all_ids = all_ids && c.area_osm_ids_.size() == c.areas_.size();
+    any_labels = any_labels || !c.label_areas_.empty();
+    auto const area_map =
+        merge_areas(c, merged, area_names, area_aliases, by_id, by_name);
+
+    auto const intern_areas = [&](std::vector<index_t> const& areas) {
+      set_areas.clear();
+      for (auto const area_idx : areas) {
+        set_areas.emplace_back(area_map[area_idx]);
+      }
+      std::sort(begin(set_areas), end(set_areas));
+      set_areas.erase(std::unique(begin(set_areas), end(set_areas)),
+                      end(set_areas));
+      return area_sets.intern(set_areas.data(),
+                              set_areas.data() + set_areas.size());
+    };
+
+    // aliases are sorted by id like the places and streets
+    auto next_alias = begin(c.aliases_);
+    auto const add_aliases = [&](size_t const id, index_t const name_idx,
+                                 index_t const area_set) {
+      for (; next_alias != end(c.aliases_) && next_alias->id_ <= id;
+           ++next_alias) {
+        if (next_alias->id_ == id) {
+          auto const alias_idx = names.intern(c.names_[next_alias->name_idx_]);
+          aliases.emplace_back(alias_record{name_idx, area_set, alias_idx});
+        }
+      }
+    };
+
+    for (auto i = size_t(0); i != c.places_.size(); ++i) {
+      auto const& p = c.places_[i];
+      auto const name_idx = names.intern(c.names_[p.name_idx_]);
+      auto const area_set = intern_areas(p.areas_);
+      records.emplace_back(
+          place_record{name_idx, 0, p.coordinates_, area_set});
+      add_aliases(i, name_idx, area_set);
+    }
+
+    // house number ranges are sorted by id as well
+    auto next_interpolation = begin(c.interpolations_);
+    auto const add_interpolations = [&](size_t const id, index_t const name_idx,
+                                        index_t const area_set) {
+      for (; next_interpolation != end(c.interpolations_) &&
+             next_interpolation->id_ <= id;
+           ++next_interpolation) {
+        if (next_interpolation->id_ == id) {
+          interpolations.emplace_back(
+              interpolation_record{name_idx, area_set, *next_interpolation});
+        }
+      }
+    };
+
+    auto hn_map = std::vector<index_t>(c.house_numbers_.size());
+    for (auto i = size_t(0); i != c.house_numbers_.size(); ++i) {
+      hn_map[i] = house_numbers.intern(c.house_numbers_[i]);
+    }
+    for (auto i = size_t(0); i != c.streets_.size(); ++i) {
+      auto const& s = c.streets_[i];
+      auto const name_idx = names.intern(c.names_[s.name_idx_]);
+      auto const area_set = intern_areas(s.areas_);
+      add_aliases(c.places_.size() + i, name_idx, area_set);
+      add_interpolations(c.places_.size() + i, name_idx, area_set);
+      for (auto const& hn : s.house_numbers_) {
+        records.emplace_back(place_record{name_idx, hn_map[hn.hn_idx_],
+                                          hn.coordinates_, area_set});
+      }
+    }
+  }
+
+  if (!all_ids) {
+    merged.area_osm_ids_.clear();
+  }
+
+  // areas contained in several contexts have the aliases of all of them
+  area_aliases.erase(std::remove_if(begin(area_aliases), end(area_aliases),
+                                    [&](alias const& a) {
+                                      auto const& area = merged.areas_[a.id_];
+                                      return area.level_ != POSTCODE &&
+                                             area.name_idx_ == a.name_idx_;
+                                    }),
+                     end(area_aliases));
+  merged.area_aliases_ = std::move(area_aliases);
+
+  merged.area_names_.resize(area_names.size());
+  for (auto i = size_t(0); i != area_names.size(); ++i) {
+    merged.area_names_[i] =
+        std::string(area_names.get(static_cast<index_t>(i)));
+  }
+
+  // same order as a single extraction, locations in the overlap of two
+  // regions (contained in both contexts) are identical records
+  canonicalize(merged, records, aliases, interpolations, names, house_numbers,
+               area_sets);
+  remove_duplicates(merged, records, std::move(aliases),
+                    std::move(interpolations), names, area_sets, num_threads);
+
+  merged.house_numbers_.resize(house_numbers.size());
+  for (auto i = size_t(0); i != house_numbers.size(); ++i) {
+    merged.house_numbers_[i] =
+        std::string(house_numbers.get(static_cast<index_t>(i)));
+  }
+  add_search_keys(merged, num_threads);
+  add_importance(merged, num_threads);
+  if (any_labels) {
+    add_labels(merged, num_threads);
+  }
+  return merged;
+}
+
+}  // namespace address_typeahead
@@ -0,0 +1,391 @@
+#include "address-typeahead/ngram_index.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace address_typeahead {
+
+namespace {
+
+constexpr auto const NUM_GRAMS = size_t(1) << 24U;
+constexpr auto const SMALL_INDEX_SIZE = size_t(1) << 16U;
+constexpr auto const END = std::numeric_limits<uint32_t>::max();
+
+void write_varint(std::vector<uint8_t>& out, uint32_t val) {
+  while (val >= 0x80) {
+    out.push_back(static_cast<uint8_t>(val | 0x80U));
+    val >>= 7U;
+  }
+  out.push_back(static_cast<uint8_t>(val));
+}
+
+uint32_t read_varint(uint8_t const*& it) {
+  auto val = uint32_t(0);
+  auto shift = 0U;
+  while ((*it & 0x80U) != 0) {
+    val |= static_cast<uint32_t>(*it & 0x7FU) << shift;
+    shift += 7;
+    ++it;
+  }
+  val |= static_cast<uint32_t>(*it) << shift;
+  ++it;
+  return val;
+}
+
+// position in the posting list of one query trigram
+struct cursor {
+  void load_block(ngram_index const& index) {
+    auto const& b = index.blocks_[block_];
+    candidate_ = b.first_;
+    ptr_ = index.postings_.data() + b.offset_;
+    pos_ = 0;
+    auto const first = (block_ - term_->first_block_) *
+                       ngram_index::POSTING_BLOCK_SIZE;
+    block_size_ =
+        std::min(ngram_index::POSTING_BLOCK_SIZE, term_->count_ - first);
+  }
+
+  void next(ngram_index const& index) {
+    if (pos_ + 1 < block_size_) {
+      candidate_ += read_varint(ptr_);
+      ++pos_;
+    } else if (++block_ != block_end_) {
+      load_block(index);
+    } else {
+      candidate_ = END;
+    }
+  }
+
+  // skips whole blocks whose last candidate is smaller than target
+  void next_geq(ngram_index const& index, uint32_t const target) {
+    if (candidate_ >= target) {
+      return;
+    }
+    if (index.blocks_[block_].last_ < target) {
+      do {
+        ++block_;
+      } while (block_ != block_end_ && index.blocks_[block_].last_ < target);
+      if (block_ == block_end_) {
+        candidate_ = END;
+        return;
+      }
+      load_block(index);
+    }
+    while (candidate_ < target) {
+      next(index);
+    }
+  }
+
+  ngram_index::term const* term_;
+  float max_score_;
+  uint32_t block_;
+  uint32_t block_end_;
+  uint32_t pos_;
+  uint32_t block_size_;
+  uint32_t candidate_;
+  uint8_t const* ptr_;
+};
+
+bool better(ngram_match const& a, ngram_match const& b) {
+  return a.cos_sim_ > b.cos_sim_ ||
+         (a.cos_sim_ == b.cos_sim_ && a.index_ < b.index_);
+}
+
+template <typename Trigrams>
+void trigrams_of(std::string_view const str, Trigrams& trigrams) {
+  trigrams.clear();
+  if (str.empty()) {
+    return;
+  }
+
+  auto const lower = [&](size_t const i) -> uint32_t {
+    if (i == 0 || i == str.size() + 1) {
+      return ' ';
+    }
+    auto const c = static_cast<unsigned char>(str[i - 1]);
+    return (c >= 'A' && c <= 'Z') ? c - 'A' + 'a' : c;
+  };
+
+  for (auto i = size_t(0); i + 3 <= str.size() + 2; ++i) {
+    trigrams.push_back((lower(i) << 16U) | (lower(i + 1) << 8U) |
+                       lower(i + 2));
+  }
+  std::sort(begin(trigrams), end(trigrams));
+  trigrams.erase(std::unique(begin(trigrams), end(trigrams)), end(trigrams));
+}
+
+}  // namespace
+
+void get_trigrams(std::string_view const str,
+                  std::vector<uint32_t>& trigrams) {
+  trigrams_of(str, trigrams);
+}
+
+void get_trigrams(std::string_view const str,
+                  std::pmr::vector<uint32_t>& trigrams) {
+  trigrams_of(str, trigrams);
+}
+
+void ngram_index::add_term(uint32_t const gram, uint32_t const* begin,
+                           uint32_t const* end) {
+  auto t = term{gram, static_cast<uint32_t>(end - begin),
+                static_cast<uint32_t>(blocks_.size()), 0.0F};
+  for (auto b = begin; b < end; b += POSTING_BLOCK_SIZE) {
+    auto const b_end = b + std::min(static_cast<ptrdiff_t>(POSTING_BLOCK_SIZE),
+                                    end - b);
+    blocks_.push_back(block{*b, *(b_end - 1), postings_.size()});
+    for (auto it = b; it != b_end; ++it) {
+      if (it != b) {
+        write_varint(postings_, *it - *(it - 1));
+      }
+      t.max_score_ = std::max(t.max_score_, candidate_scores_[*it]);
+    }
+  }
+  terms_.push_back(t);
+}
+
+ngram_index::ngram_index(
+    std::vector<std::pair<std::string, float>> const& strings) {
+  auto trigrams = std::vector<uint32_t>();
+  candidate_scores_.resize(strings.size());
+  for (auto i = size_t(0); i != strings.size(); ++i) {
+    get_trigrams(strings[i].first, trigrams);
+    candidate_scores_[i] =
+        trigrams.empty()
+            ? 0.0F
+            : static_cast<float>(strings[i].second /
+                                 std::sqrt(static_cast<double>(
+                                     trigrams.size())));
+  }
+
+  if (strings.size() <= SMALL_INDEX_SIZE) {
+    // small indices (e.g. for reranking) sort (trigram, candidate) pairs
+    auto pairs = std::vector<uint64_t>();
+    for (auto i = size_t(0); i != strings.size(); ++i) {
+      get_trigrams(strings[i].first, trigrams);
+      for (auto const gram : trigrams) {
+        pairs.push_back((static_cast<uint64_t>(gram) << 32U) | i);
+      }
+    }
+    std::sort(begin(pairs), end(pairs));
+
+    auto candidates = std::vector<uint32_t>();
+    for (auto it = begin(pairs); it != end(pairs);) {
+      auto const gram = static_cast<uint32_t>(*it >> 32U);
+      candidates.clear();
+      for (; it != end(pairs) && (*it >> 32U) == gram; ++it) {
+        candidates.push_back(static_cast<uint32_t>(*it));
+      }
+      add_term(gram, candidates.data(),
+               candidates.data() + candidates.size());
+    }
+  } else {
+    // count the candidates of every trigram (offsets are the ends of the
+    // trigrams), then fill them back to front: the offsets become the
+    // beginnings and the candidates are in ascending order
+    auto offsets = std::vector<uint32_t>(NUM_GRAMS + 1, 0);
+    for (auto const& str : strings) {
+      get_trigrams(str.first, trigrams);
+      for (auto const gram : trigrams) {
+        ++offsets[gram];
+      }
+    }
+    for (auto i = size_t(1); i != offsets.size(); ++i) {
+      offsets[i] += offsets[i - 1];
+    }
+
+    auto candidates = std::vector<uint32_t>(offsets.back());
+    for (auto i = strings.size(); i != 0; --i) {
+      get_trigrams(strings[i - 1].first, trigrams);
+      for (auto const gram : trigrams) {
+        candidates[--offsets[gram]] = static_cast<uint32_t>(i - 1);
+      }
+    }
+
+    for (auto gram = uint32_t(0); gram != NUM_GRAMS; ++gram) {
+      if (offsets[gram] != offsets[gram + 1]) {
+        add_term(gram, candidates.data() + offsets[gram],
+                 candidates.data() + offsets[gram + 1]);
+      }
+    }
+  }
+  terms_.push_back(term{END, 0, static_cast<uint32_t>(blocks_.size()), 0.0F});
+}
+
+std::vector<ngram_match> ngram_index::match(std::string const& str,
+                                            size_t const count) const {
+  auto results = std::pmr::vector<ngram_match>();
+  match(str, count, results);
+  return std::vector<ngram_match>(begin(results), end(results));
+}
+
+void ngram_index::match(std::string_view const str, size_t const count,
+                        std::pmr::vector<ngram_match>& results) const {
+  auto const resource = results.get_allocator().resource();
+  results.clear();
+
+  auto trigrams = std::pmr::vector<uint32_t>(resource);
+  get_trigrams(str, trigrams);
+  if (trigrams.empty() || count == 0) {
+    return;
+  }
+
+  auto const inv_query_norm = static_cast<float>(
+      1.0 / std::sqrt(static_cast<double>(trigrams.size())));
+
+  auto cursors = std::pmr::vector<cursor>(resource);
+  cursors.reserve(trigrams.size());
+  for (auto const gram : trigrams) {
+    auto const t = std::lower_bound(
+        begin(terms_), end(terms_) - 1, gram,
+        [](term const& a, uint32_t const g) { return a.gram_ < g; });
+    if (t->gram_ != gram) {
+      continue;
+    }
+    auto c = cursor();
+    c.term_ = &*t;
+    c.max_score_ = t->max_score_ * inv_query_norm;
+    c.block_ = t->first_block_;
+    c.block_end_ = (t + 1)->first_block_;
+    c.load_block(*this);
+    cursors.push_back(c);
+  }
+
+  // min heap of the best candidates found so far (worst on top)
+  results.reserve(std::min(count, size()));
+  auto const worse = [](ngram_match const& a, ngram_match const& b) {
+    return better(a, b);
+  };
+
+  auto const by_candidate = [](cursor const& a, cursor const& b) {
+    return a.candidate_ < b.candidate_;
+  };
+  while (true) {
+    std::sort(begin(cursors), end(cursors), by_candidate);
+
+    // pivot: first cursor at which the summed upper bounds reach the
+    // threshold, no candidate before it can enter the results
+    auto const full = results.size() == count;
+    auto const threshold = full ? results.front().cos_sim_ : 0.0F;
+    auto upper_bound = 0.0F;
+    auto pivot = cursors.size();
+    for (auto i = size_t(0); i != cursors.size(); ++i) {
+      if (cursors[i].candidate_ == END) {
+        break;
+      }
+      // the slack keeps candidates tying the threshold despite rounding
+      upper_bound += cursors[i].max_score_;
+      if (!full || upper_bound * 1.0001F >= threshold) {
+        pivot = i;
+        break;
+      }
+    }
+    if (pivot == cursors.size()) {
+      break;
+    }
+
+    auto const candidate = cursors[pivot].candidate_;
+    if (cursors[0].candidate_ != candidate) {
+      for (auto i = size_t(0); i != pivot; ++i) {
+        cursors[i].next_geq(*this, candidate);
+      }
+      continue;
+    }
+
+    auto hits = 0U;
+    for (auto& c : cursors) {
+      if (c.candidate_ == candidate) {
+        ++hits;
+        c.next(*this);
+      }
+    }
+
+    auto const m = ngram_match{
+        candidate, static_cast<float>(hits) * candidate_scores_[candidate] *
+                       inv_query_norm};
+    if (m.cos_sim_ <= 0.0F) {
+      continue;
+    }
+    if (!full) {
+      results.push_back(m);
+      std::push_heap(begin(results), end(results), worse);
+    } else if (better(m, results.front())) {
+      std::pop_heap(begin(results), end(results), worse);
+      results.back() = m;
+      std::push_heap(begin(results), end(results), worse);
+    }
+  }
+
+  std::sort(begin(results), end(results), better);
+}
+
+ngram_scorer::ngram_scorer(std::pmr::memory_resource* const resource)
+    : grams_(resource),
+      offsets_(1, 0, resource),
+      scores_(resource),
+      trigrams_(resource) {}
+
+void ngram_scorer::add(std::string_view const str, float const weight) {
+  get_trigrams(str, trigrams_);
+  grams_.insert(end(grams_), begin(trigrams_), end(trigrams_));
+  offsets_.push_back(static_cast<uint32_t>(grams_.size()));
+  scores_.push_back(trigrams_.empty()
+                        ? 0.0F
+                        : static_cast<float>(weight /
+                                             std::sqrt(static_cast<double>(
+                                                 trigrams_.size()))));
+}
+
+void ngram_scorer::match(std::string_view const str, size_t const count,
+                         std::pmr::vector<ngram_match>& results) const {
+  results.clear();
+  auto trigrams =
+      std::pmr::vector<uint32_t>(results.get_allocator().resource());
+  get_trigrams(str, trigrams);
+  if (trigrams.empty() || count == 0) {
+    return;
+  }
+
+  auto const inv_query_norm = static_cast<float>(
+      1.0 / std::sqrt(static_cast<double>(trigrams.size())));
+  for (auto i = size_t(0); i != size(); ++i) {
+    // both trigram lists are sorted
+    auto hits = 0U;
+    auto a = begin(trigrams);
+    auto b = begin(grams_) + offsets_[i];
+    auto const b_end = begin(grams_) + offsets_[i + 1];
+    while (a != end(trigrams) && b != b_end) {
+      if (*a < *b) {
+        ++a;
+      } else if (*b < *a) {
+        ++b;
+      } else {
+        ++hits;
+        ++a;
+        ++b;
+      }
+    }
+
+    auto const m = ngram_match{
+        static_cast<index_t>(i),
+        static_cast<float>(hits) * scores_[i] * inv_query_norm};
+    if (m.cos_sim_ > 0.0F) {
+      results.push_back(m);
+    }
+  }
+
+  if (results.size() > count) {
+    std::nth_element(begin(results), begin(results) + count, end(results),
+                     better);
+    results.resize(count);
+  }
+  std::sort(begin(results), end(results), better);
+}
+
+size_t ngram_index::byte_size() const {
+  return terms_.size() * sizeof(term) + blocks_.size() * sizeof(block) +
+         postings_.size() + candidate_scores_.size() * sizeof(float);
+}
+
+}  // namespace address_typeahead
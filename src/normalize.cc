@@ -0,0 +1,149 @@
+#include "address-typeahead/normalize.h"
+
+#include <cstdint>
+
+namespace address_typeahead {
+
+namespace {
+
+struct fold_range {
+  uint32_t first_;
+  uint32_t last_;
+  char const* replacement_;
+};
+
+// Latin-1 Supplement and Latin Extended-A, upper and lower case letters
+// fold to the same replacement
+constexpr fold_range const FOLDS[] = {
+    {0xC0, 0xC3, "a"},     {0xC4, 0xC4, "ae"},    {0xC5, 0xC5, "a"},
+    {0xC6, 0xC6, "ae"},    {0xC7, 0xC7, "c"},     {0xC8, 0xCB, "e"},
+    {0xCC, 0xCF, "i"},     {0xD0, 0xD0, "d"},     {0xD1, 0xD1, "n"},
+    {0xD2, 0xD5, "o"},     {0xD6, 0xD6, "oe"},    {0xD8, 0xD8, "o"},
+    {0xD9, 0xDB, "u"},     {0xDC, 0xDC, "ue"},    {0xDD, 0xDD, "y"},
+    {0xDE, 0xDE, "th"},    {0xDF, 0xDF, "ss"},    {0xE0, 0xE3, "a"},
+    {0xE4, 0xE4, "ae"},    {0xE5, 0xE5, "a"},     {0xE6, 0xE6, "ae"},
+    {0xE7, 0xE7, "c"},     {0xE8, 0xEB, "e"},     {0xEC, 0xEF, "i"},
+    {0xF0, 0xF0, "d"},     {0xF1, 0xF1, "n"},     {0xF2, 0xF5, "o"},
+    {0xF6, 0xF6, "oe"},    {0xF8, 0xF8, "o"},     {0xF9, 0xFB, "u"},
+    {0xFC, 0xFC, "ue"},    {0xFD, 0xFD, "y"},     {0xFE, 0xFE, "th"},
+    {0xFF, 0xFF, "y"},     {0x100, 0x105, "a"},   {0x106, 0x10D, "c"},
+    {0x10E, 0x111, "d"},   {0x112, 0x11B, "e"},   {0x11C, 0x123, "g"},
+    {0x124, 0x127, "h"},   {0x128, 0x131, "i"},   {0x132, 0x133, "ij"},
+    {0x134, 0x135, "j"},   {0x136, 0x138, "k"},   {0x139, 0x142, "l"},
+    {0x143, 0x14B, "n"},   {0x14C, 0x151, "o"},   {0x152, 0x153, "oe"},
+    {0x154, 0x159, "r"},   {0x15A, 0x161, "s"},   {0x162, 0x167, "t"},
+    {0x168, 0x173, "u"},   {0x174, 0x175, "w"},   {0x176, 0x178, "y"},
+    {0x179, 0x17E, "z"},   {0x17F, 0x17F, "s"}};
+
+char const* fold(uint32_t const code_point) {
+  for (auto const& f : FOLDS) {
+    if (code_point >= f.first_ && code_point <= f.last_) {
+      return f.replacement_;
+    }
+  }
+  return nullptr;
+}
+
+bool ends_with(std::string_view const str, std::string_view const suffix) {
+  return str.size() >= suffix.size() &&
+         str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+// the finished token is the suffix of out starting at token_start
+template <typename String>
+void expand_abbreviation(String& out, size_t const token_start) {
+  auto const token_length = out.size() - token_start;
+  if (ends_with(out, "str.")) {
+    out.resize(out.size() - 1);
+    out += "asse";
+  } else if (token_length == 3 && ends_with(out, "pl.")) {
+    out.resize(out.size() - 1);
+    out += "atz";
+  }
+}
+
+template <typename String>
+void normalize_to(std::string_view const str, String& out) {
+  out.clear();
+  out.reserve(str.size() + 8);
+
+  auto token_start = size_t(0);
+  auto const finish_token = [&]() {
+    if (out.size() != token_start) {
+      expand_abbreviation(out, token_start);
+    }
+  };
+
+  for (auto i = size_t(0); i < str.size();) {
+    auto const c = static_cast<unsigned char>(str[i]);
+    if (c < 0x80) {
+      ++i;
+      if (c == ' ' || c == '\t' || c == '\n' || c == '\r') {
+        finish_token();
+        if (!out.empty() && out.back() != ' ') {
+          out.push_back(' ');
+        }
+        token_start = out.size();
+      } else {
+        out.push_back(static_cast<char>(
+            (c >= 'A' && c <= 'Z') ? c - 'A' + 'a' : c));
+      }
+      continue;
+    }
+
+    // two byte sequences cover the folded code points, everything else is
+    // copied unchanged
+    if ((c & 0xE0U) == 0xC0U && i + 1 < str.size()) {
+      auto const next = static_cast<unsigned char>(str[i + 1]);
+      auto const code_point = ((c & 0x1FU) << 6U) | (next & 0x3FU);
+      auto const replacement = fold(code_point);
+      if (replacement != nullptr) {
+        out += replacement;
+        i += 2;
+        continue;
+      }
+    }
+
+    auto length = size_t(1);
+    if ((c & 0xE0U) == 0xC0U) {
+      length = 2;
+    } else if ((c & 0xF0U) == 0xE0U) {
+      length = 3;
+    } else if ((c & 0xF8U) == 0xF0U) {
+      length = 4;
+    }
+    out.append(str.substr(i, length));
+    i += length;
+  }
+  finish_token();
+
+  if (!out.empty() && out.back() == ' ') {
+    out.pop_back();
+  }
+}
+
+}  // namespace
+
+std::string normalize(std::string_view const str) {
+  auto out = std::string();
+  normalize_to(str, out);
+  return out;
+}
+
+void normalize(std::string_view const str, std::pmr::string& out) {
+  normalize_to(str, out);
+}
+
+void add_search_keys(typeahead_context& context, unsigned const num_threads) {
+  context.name_keys_.resize(context.names_.size());
+  parallel_for(context.names_.size(), num_threads, [&](size_t const i) {
+    context.name_keys_[i] = normalize(context.names_[i]);
+  });
+
+  context.area_name_keys_.resize(context.area_names_.size());
+  parallel_for(context.area_names_.size(), num_threads, [&](size_t const i) {
+    context.area_name_keys_[i] = normalize(context.area_names_[i]);
+  });
+}
+
+}  // namespace address_typeahead
@@ -0,0 +1,402 @@
+#include "address-typeahead/place_records.h"
+
+#include <algorithm>
+#include <iterator>
+#include <numeric>
+#include <string>
+#include <tuple>
+
+#include "address-typeahead/parallel_for.h"
+
+namespace address_typeahead {
+
+namespace {
+
+struct unique_entities {
+  std::vector<location> places_;
+  std::vector<street> streets_;
+
+  // ids are indices into places_ / streets_ of this chunk
+  std::vector<alias> place_aliases_;
+  std::vector<alias> street_aliases_;
+  std::vector<interpolation> street_interpolations_;
+};
+
+// names are processed in chunks, every chunk writes into its own result slot
+constexpr auto const NAMES_PER_CHUNK = size_t(1024);
+
+// new id of every string: sorted order of the used ones
+std::vector<index_t> sort_strings(string_interner& strings,
+                                  std::vector<bool> const& used) {
+  auto order = std::vector<index_t>();
+  for (auto i = index_t(0); i != strings.size(); ++i) {
+    if (used[i]) {
+      order.push_back(i);
+    }
+  }
+  std::sort(begin(order), end(order), [&](index_t const a, index_t const b) {
+    return strings.get(a) < strings.get(b);
+  });
+
+  auto sorted = string_interner();
+  auto map = std::vector<index_t>(strings.size(), 0);
+  for (auto const i : order) {
+    map[i] = sorted.intern(strings.get(i));
+  }
+  strings = std::move(sorted);
+  return map;
+}
+
+}  // namespace
+
+void canonicalize(typeahead_context& context,
+                  std::vector<place_record>& records,
+                  std::vector<alias_record>& aliases,
+                  std::vector<interpolation_record>& interpolations,
+                  string_interner& names, string_interner& house_numbers,
+                  index_set_interner& area_sets) {
+  auto const num_areas = context.areas_.size();
+  auto const has_ids = context.area_osm_ids_.size() == num_areas;
+  auto const has_population = context.area_population_.size() == num_areas;
+  auto const area_name = [&](area const& a) {
+    return a.level_ == POSTCODE ? std::to_string(a.name_idx_)
+                                : context.area_names_[a.name_idx_];
+  };
+
+  // areas
+  auto area_order = std::vector<index_t>(num_areas);
+  std::iota(begin(area_order), end(area_order), index_t(0));
+  std::stable_sort(begin(area_order), end(area_order),
+                   [&](index_t const a, index_t const b) {
+                     if (has_ids) {
+                       return context.area_osm_ids_[a] <
+                              context.area_osm_ids_[b];
+                     }
+                     auto const& area_a = context.areas_[a];
+                     auto const& area_b = context.areas_[b];
+                     return std::make_pair(area_a.level_, area_name(area_a)) <
+                            std::make_pair(area_b.level_, area_name(area_b));
+                   });
+  auto area_map = std::vector<index_t>(num_areas);
+  for (auto i = size_t(0); i != num_areas; ++i) {
+    area_map[area_order[i]] = static_cast<index_t>(i);
+  }
+
+  auto area_name_order = std::vector<index_t>(context.area_names_.size());
+  std::iota(begin(area_name_order), end(area_name_order), index_t(0));
+  std::stable_sort(begin(area_name_order), end(area_name_order),
+                   [&](index_t const a, index_t const b) {
+                     return context.area_names_[a] < context.area_names_[b];
+                   });
+  auto area_name_map = std::vector<index_t>(area_name_order.size());
+  auto area_names = std::vector<std::string>(area_name_order.size());
+  for (auto i = size_t(0); i != area_name_order.size(); ++i) {
+    area_name_map[area_name_order[i]] = static_cast<index_t>(i);
+    area_names[i] = std::move(context.area_names_[area_name_order[i]]);
+  }
+  context.area_names_ = std::move(area_names);
+
+  auto areas = std::vector<area>(num_areas);
+  auto osm_ids = std::vector<int64_t>(has_ids ? num_areas : 0U);
+  auto population = std::vector<uint64_t>(has_population ? num_areas : 0U);
+  for (auto i = size_t(0); i != num_areas; ++i) {
+    auto a = context.areas_[area_order[i]];
+    if (a.level_ != POSTCODE) {
+      a.name_idx_ = area_name_map[a.name_idx_];
+    }
+    areas[i] = a;
+    if (has_ids) {
+      osm_ids[i] = context.area_osm_ids_[area_order[i]];
+    }
+    if (has_population) {
+      population[i] = context.area_population_[area_order[i]];
+    }
+  }
+  context.areas_ = std::move(areas);
+  context.area_osm_ids_ = std::move(osm_ids);
+  context.area_population_ = std::move(population);
+
+  for (auto& a : context.area_aliases_) {
+    a = alias{area_map[a.id_], area_name_map[a.name_idx_]};
+  }
+  auto const area_alias_key = [](alias const& a) {
+    return std::make_pair(a.id_, a.name_idx_);
+  };
+  std::sort(begin(context.area_aliases_), end(context.area_aliases_),
+            [&](alias const& a, alias const& b) {
+              return area_alias_key(a) < area_alias_key(b);
+            });
+  context.area_aliases_.erase(
+      std::unique(begin(context.area_aliases_), end(context.area_aliases_),
+                  [&](alias const& a, alias const& b) {
+                    return area_alias_key(a) == area_alias_key(b);
+                  }),
+      end(context.area_aliases_));
+
+  if (has_population) {
+    context.population_sum_ = std::accumulate(
+        begin(context.area_population_), end(context.area_population_),
+        uint64_t(0));
+    auto const inv_population_sum =
+        context.population_sum_ == 0
+            ? 0.0
+            : 1.0 / static_cast<double>(context.population_sum_);
+    for (auto i = size_t(0); i != num_areas; ++i) {
+      context.areas_[i].popularity_ = static_cast<float>(
+          1.0 + static_cast<double>(context.area_population_[i]) *
+                    inv_population_sum);
+    }
+  }
+
+  // names and house numbers
+  auto used_names = std::vector<bool>(names.size(), false);
+  auto used_house_numbers = std::vector<bool>(house_numbers.size(), false);
+  used_house_numbers[0] = true;
+  for (auto const& r : records) {
+    used_names[r.name_idx_] = true;
+    used_house_numbers[r.hn_idx_] = true;
+  }
+  for (auto const& a : aliases) {
+    used_names[a.name_idx_] = true;
+    used_names[a.alias_idx_] = true;
+  }
+  for (auto const& i : interpolations) {
+    used_names[i.name_idx_] = true;
+  }
+  auto const name_map = sort_strings(names, used_names);
+  auto const house_number_map = sort_strings(house_numbers, used_house_numbers);
+
+  // area sets: renumbered, then ordered by their areas
+  auto used_sets = std::vector<bool>(area_sets.size(), false);
+  for (auto const& r : records) {
+    used_sets[r.area_set_] = true;
+  }
+  auto set_data = std::vector<index_t>();
+  auto set_offsets = std::vector<uint64_t>{0};
+  auto set_order = std::vector<index_t>();
+  for (auto s = index_t(0); s != area_sets.size(); ++s) {
+    if (used_sets[s]) {
+      for (auto i = area_sets.offsets_[s]; i != area_sets.offsets_[s + 1];
+           ++i) {
+        set_data.push_back(area_map[area_sets.data_[i]]);
+      }
+      std::sort(begin(set_data) + set_offsets.back(), end(set_data));
+      set_order.push_back(s);
+    }
+    set_offsets.push_back(set_data.size());
+  }
+  std::sort(begin(set_order), end(set_order),
+            [&](index_t const a, index_t const b) {
+              return std::lexicographical_compare(
+                  begin(set_data) + set_offsets[a],
+                  begin(set_data) + set_offsets[a + 1],
+                  begin(set_data) + set_offsets[b],
+                  begin(set_data) + set_offsets[b + 1]);
+            });
+  auto sorted_sets = index_set_interner();
+  auto set_map = std::vector<index_t>(area_sets.size(), 0);
+  for (auto const s : set_order) {
+    set_map[s] = sorted_sets.intern(set_data.data() + set_offsets[s],
+                                    set_data.data() + set_offsets[s + 1]);
+  }
+  area_sets = std::move(sorted_sets);
+
+  for (auto& r : records) {
+    r.name_idx_ = name_map[r.name_idx_];
+    r.hn_idx_ = house_number_map[r.hn_idx_];
+    r.area_set_ = set_map[r.area_set_];
+  }
+  for (auto& a : aliases) {
+    a.name_idx_ = name_map[a.name_idx_];
+    a.area_set_ = set_map[a.area_set_];
+    a.alias_idx_ = name_map[a.alias_idx_];
+  }
+  for (auto& i : interpolations) {
+    i.name_idx_ = name_map[i.name_idx_];
+    i.area_set_ = set_map[i.area_set_];
+  }
+}
+
+void remove_duplicates(typeahead_context& context,
+                       std::vector<place_record> const& records,
+                       std::vector<alias_record> aliases,
+                       std::vector<interpolation_record> interpolations,
+                       string_interner const& names,
+                       index_set_interner const& area_sets,
+                       unsigned const num_threads) {
+  // counting sort of the records by name
+  auto name_offsets = std::vector<uint64_t>(names.size() + 1, 0);
+  for (auto const& r : records) {
+    ++name_offsets[r.name_idx_ + 1];
+  }
+  for (auto i = size_t(1); i != name_offsets.size(); ++i) {
+    name_offsets[i] += name_offsets[i - 1];
+  }
+  auto order = std::vector<uint32_t>(records.size());
+  {
+    auto next = name_offsets;
+    for (auto i = uint32_t(0); i != records.size(); ++i) {
+      order[next[records[i].name_idx_]++] = i;
+    }
+  }
+
+  auto const alias_key = [](alias_record const& a) {
+    return std::tie(a.name_idx_, a.area_set_, a.alias_idx_);
+  };
+  std::sort(begin(aliases), end(aliases),
+            [&](alias_record const& a, alias_record const& b) {
+              return alias_key(a) < alias_key(b);
+            });
+  aliases.erase(std::unique(begin(aliases), end(aliases),
+                            [&](alias_record const& a, alias_record const& b) {
+                              return alias_key(a) == alias_key(b);
+                            }),
+                end(aliases));
+
+  // ranges contained in several inputs (merge) are kept once
+  auto const interpolation_key = [](interpolation_record const& r) {
+    return std::tie(r.name_idx_, r.area_set_, r.interpolation_.first_,
+                    r.interpolation_.last_, r.interpolation_.step_);
+  };
+  std::sort(begin(interpolations), end(interpolations),
+            [&](interpolation_record const& a, interpolation_record const& b) {
+              return interpolation_key(a) < interpolation_key(b);
+            });
+  interpolations.erase(
+      std::unique(begin(interpolations), end(interpolations),
+                  [&](interpolation_record const& a,
+                      interpolation_record const& b) {
+                    return interpolation_key(a) == interpolation_key(b);
+                  }),
+      end(interpolations));
+
+  context.names_.resize(names.size());
+  auto const num_chunks =
+      (names.size() + NAMES_PER_CHUNK - 1) / NAMES_PER_CHUNK;
+  auto results = std::vector<unique_entities>(num_chunks);
+  parallel_for(num_chunks, num_threads, [&](size_t const chunk_idx) {
+    auto& result = results[chunk_idx];
+    auto const names_begin = chunk_idx * NAMES_PER_CHUNK;
+    auto const names_end =
+        std::min(names_begin + NAMES_PER_CHUNK, names.size());
+    for (auto name_idx = names_begin; name_idx != names_end; ++name_idx) {
+      context.names_[name_idx] = std::string(names.get(name_idx));
+
+      // group by area set, house numbers ascending, ties by coordinates:
+      // the result does not depend on the input order
+      auto const key = [&](uint32_t const r) {
+        auto const& record = records[r];
+        return std::tie(record.area_set_, record.hn_idx_,
+                        record.coordinates_.lon_, record.coordinates_.lat_);
+      };
+      auto const begin = order.begin() + name_offsets[name_idx];
+      auto const end = order.begin() + name_offsets[name_idx + 1];
+      std::sort(begin, end, [&](uint32_t const a, uint32_t const b) {
+        return key(a) < key(b);
+      });
+
+      for (auto group_begin = begin; group_begin != end;) {
+        auto const area_set = records[*group_begin].area_set_;
+        auto const group_end =
+            std::find_if(group_begin, end, [&](uint32_t const r) {
+              return records[r].area_set_ != area_set;
+            });
+
+        // aliases of the group, the primary name is skipped
+        auto const add_aliases = [&](std::vector<alias>& entity_aliases,
+                                     size_t const entity_idx) {
+          auto it = std::lower_bound(
+              aliases.begin(), aliases.end(),
+              std::make_pair(static_cast<index_t>(name_idx), area_set),
+              [](alias_record const& a, std::pair<index_t, index_t> const& k) {
+                return std::make_pair(a.name_idx_, a.area_set_) < k;
+              });
+          for (; it != aliases.end() && it->name_idx_ == name_idx &&
+                 it->area_set_ == area_set;
+               ++it) {
+            if (it->alias_idx_ != name_idx) {
+              entity_aliases.emplace_back(
+                  alias{static_cast<index_t>(entity_idx), it->alias_idx_});
+            }
+          }
+        };
+
+        // a group without any house number becomes a place, otherwise a
+        // street with the house numbers of the group
+        auto const& last = records[*(group_end - 1)];
+        if (last.hn_idx_ == 0) {
+          add_aliases(result.place_aliases_, result.places_.size());
+          location new_place;
+          new_place.name_idx_ = static_cast<index_t>(name_idx);
+          new_place.coordinates_ = last.coordinates_;
+          new_place.areas_ = area_sets.get(area_set);
+          result.places_.emplace_back(std::move(new_place));
+        } else {
+          add_aliases(result.street_aliases_, result.streets_.size());
+          street new_street;
+          new_street.name_idx_ = static_cast<index_t>(name_idx);
+          for (auto it = group_begin; it != group_end; ++it) {
+            auto const& r = records[*it];
+            if (r.hn_idx_ != 0 &&
+                (it == group_begin || key(*it) != key(*(it - 1)))) {
+              new_street.house_numbers_.emplace_back(
+                  house_number{r.hn_idx_, r.coordinates_});
+            }
+          }
+          new_street.areas_ = area_sets.get(area_set);
+
+          // every group is handled by one chunk, its ranges are moved
+          auto it = std::lower_bound(
+              interpolations.begin(), interpolations.end(),
+              std::make_pair(static_cast<index_t>(name_idx), area_set),
+              [](interpolation_record const& r,
+                 std::pair<index_t, index_t> const& k) {
+                return std::make_pair(r.name_idx_, r.area_set_) < k;
+              });
+          for (; it != interpolations.end() && it->name_idx_ == name_idx &&
+                 it->area_set_ == area_set;
+               ++it) {
+            it->interpolation_.id_ =
+                static_cast<index_t>(result.streets_.size());
+            result.street_interpolations_.emplace_back(
+                std::move(it->interpolation_));
+          }
+          result.streets_.emplace_back(std::move(new_street));
+        }
+        group_begin = group_end;
+      }
+    }
+  });
+
+  auto num_places = size_t(0);
+  for (auto const& result : results) {
+    num_places += result.places_.size();
+  }
+
+  // places come first, aliases_ and interpolations_ are sorted by id
+  auto const add_aliases = [&](std::vector<alias> const& chunk_aliases,
+                               size_t const offset) {
+    for (auto const& a : chunk_aliases) {
+      context.aliases_.emplace_back(
+          alias{static_cast<index_t>(offset + a.id_), a.name_idx_});
+    }
+  };
+  context.places_.reserve(context.places_.size() + num_places);
+  for (auto& result : results) {
+    add_aliases(result.place_aliases_, context.places_.size());
+    std::move(result.places_.begin(), result.places_.end(),
+              std::back_inserter(context.places_));
+  }
+  for (auto& result : results) {
+    auto const offset = num_places + context.streets_.size();
+    add_aliases(result.street_aliases_, offset);
+    for (auto& i : result.street_interpolations_) {
+      i.id_ = static_cast<index_t>(offset + i.id_);
+      context.interpolations_.emplace_back(std::move(i));
+    }
+    std::move(result.streets_.begin(), result.streets_.end(),
+              std::back_inserter(context.streets_));
+  }
+}
+
+}  // namespace address_typeahead
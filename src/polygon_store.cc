@@ -0,0 +1,430 @@
+#include "address-typeahead/polygon_store.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <utility>
+
+namespace address_typeahead {
+
+namespace {
+
+void write_varint(std::vector<uint8_t>& out, int64_t const val) {
+  auto zigzag = (static_cast<uint64_t>(val) << 1U) ^
+                static_cast<uint64_t>(val >> 63);  // NOLINT
+  while (zigzag >= 0x80) {
+    out.push_back(static_cast<uint8_t>(zigzag | 0x80U));
+    zigzag >>= 7U;
+  }
+  out.push_back(static_cast<uint8_t>(zigzag));
+}
+
+int64_t read_varint(uint8_t const*& it) {
+  auto zigzag = uint64_t(0);
+  auto shift = 0U;
+  while ((*it & 0x80U) != 0) {
+    zigzag |= static_cast<uint64_t>(*it & 0x7FU) << shift;
+    shift += 7;
+    ++it;
+  }
+  zigzag |= static_cast<uint64_t>(*it) << shift;
+  ++it;
+  return static_cast<int64_t>(zigzag >> 1U) ^ -static_cast<int64_t>(zigzag & 1U);
+}
+
+uint64_t hash(uint8_t const* begin, uint8_t const* end) {
+  auto h = uint64_t(14695981039346656037ULL);
+  for (auto it = begin; it != end; ++it) {
+    h = (h ^ *it) * 1099511628211ULL;
+  }
+  return h;
+}
+
+template <typename Points>
+void encode(Points const& points, std::vector<uint8_t>& out) {
+  auto prev_x = int64_t(0);
+  auto prev_y = int64_t(0);
+  for (auto const& p : points) {
+    write_varint(out, p.template get<0>() - prev_x);
+    write_varint(out, p.template get<1>() - prev_y);
+    prev_x = p.template get<0>();
+    prev_y = p.template get<1>();
+  }
+}
+
+template <typename Points>
+void decode(uint8_t const* it, uint8_t const* const end, Points& result) {
+  result.clear();
+  auto x = int64_t(0);
+  auto y = int64_t(0);
+  while (it != end) {
+    x += read_varint(it);
+    y += read_varint(it);
+    result.push_back(point(static_cast<int32_t>(x), static_cast<int32_t>(y)));
+  }
+}
+
+using sequence_index = std::unordered_map<uint64_t, std::vector<uint32_t>>;
+
+// the sequence encoded at data[start..] is replaced by an equal earlier one
+// (returning its id) or appended as a new sequence
+uint32_t intern_encoded(std::vector<uint8_t>& data,
+                        std::vector<uint64_t>& offsets, sequence_index& index,
+                        size_t const start) {
+  auto const begin = data.data() + start;
+  auto const end = data.data() + data.size();
+  auto& candidates = index[hash(begin, end)];
+  for (auto const candidate : candidates) {
+    auto const c_begin = data.data() + offsets[candidate];
+    auto const c_end = data.data() + offsets[candidate + 1];
+    if (std::equal(c_begin, c_end, begin, end)) {
+      data.resize(start);
+      return candidate;
+    }
+  }
+
+  auto const id = static_cast<uint32_t>(offsets.size() - 1);
+  offsets.push_back(data.size());
+  candidates.push_back(id);
+  return id;
+}
+
+// distinct arcs (point sequences between junctions), encoded like the rings
+struct arc_store {
+  uint32_t add(std::vector<point> const& points) {
+    auto const start = data_.size();
+    encode(points, data_);
+    return intern_encoded(data_, offsets_, index_, start);
+  }
+
+  void get(uint32_t const id, std::vector<point>& result) const {
+    decode(data_.data() + offsets_[id], data_.data() + offsets_[id + 1],
+           result);
+  }
+
+  size_t size() const { return offsets_.size() - 1; }
+
+  std::vector<uint8_t> data_;
+  std::vector<uint64_t> offsets_{0};
+  sequence_index index_;
+};
+
+uint64_t key(point const& p) {
+  return (static_cast<uint64_t>(static_cast<uint32_t>(p.get<0>())) << 32U) |
+         static_cast<uint32_t>(p.get<1>());
+}
+
+double segment_distance(point const& p, point const& a, point const& b) {
+  auto const px = static_cast<double>(p.get<0>());
+  auto const py = static_cast<double>(p.get<1>());
+  auto const ax = static_cast<double>(a.get<0>());
+  auto const ay = static_cast<double>(a.get<1>());
+  auto const dx = static_cast<double>(b.get<0>()) - ax;
+  auto const dy = static_cast<double>(b.get<1>()) - ay;
+  auto const length_sq = dx * dx + dy * dy;
+  auto const t =
+      length_sq == 0.0
+          ? 0.0
+          : std::clamp(((px - ax) * dx + (py - ay) * dy) / length_sq, 0.0,
+                       1.0);
+  return std::hypot(px - (ax + t * dx), py - (ay + t * dy));
+}
+
+// Douglas-Peucker keeping both end points
+void douglas_peucker(std::vector<point> const& in, double const tolerance,
+                     std::vector<point>& out) {
+  auto keep = std::vector<bool>(in.size(), false);
+  keep.front() = true;
+  keep.back() = true;
+  auto stack = std::vector<std::pair<size_t, size_t>>{{0, in.size() - 1}};
+  while (!stack.empty()) {
+    auto const [first, last] = stack.back();
+    stack.pop_back();
+    auto max_distance = 0.0;
+    auto max_i = first;
+    for (auto i = first + 1; i < last; ++i) {
+      auto const d = segment_distance(in[i], in[first], in[last]);
+      if (d > max_distance) {
+        max_distance = d;
+        max_i = i;
+      }
+    }
+    if (max_distance > tolerance) {
+      keep[max_i] = true;
+      stack.emplace_back(first, max_i);
+      stack.emplace_back(max_i, last);
+    }
+  }
+
+  out.clear();
+  for (auto i = size_t(0); i != in.size(); ++i) {
+    if (keep[i]) {
+      out.push_back(in[i]);
+    }
+  }
+}
+
+}  // namespace
+
+uint32_t polygon_store::add_ring(ring const& r) {
+  auto const start = ring_data_.size();
+  encode(r, ring_data_);
+  return intern_encoded(ring_data_, ring_offsets_, ring_index_, start);
+}
+
+void polygon_store::read_ring(uint32_t const ring_id,
+                              std::vector<point>& result) const {
+  decode(ring_data_.data() + ring_offsets_[ring_id],
+         ring_data_.data() + ring_offsets_[ring_id + 1], result);
+}
+
+index_t polygon_store::add(multi_polygon const& mp) {
+  polygon_rings_.push_back(static_cast<uint32_t>(mp.size()));
+  for (auto const& pol : mp) {
+    polygon_rings_.push_back(static_cast<uint32_t>(pol.inners().size() + 1));
+    polygon_rings_.push_back(add_ring(pol.outer()));
+    for (auto const& inner : pol.inners()) {
+      polygon_rings_.push_back(add_ring(inner));
+    }
+  }
+  polygon_offsets_.push_back(polygon_rings_.size());
+  return static_cast<index_t>(polygon_offsets_.size() - 2);
+}
+
+multi_polygon polygon_store::get(index_t const id) const {
+  auto const read_ring = [&](uint32_t const ring_id, ring& r) {
+    decode(ring_data_.data() + ring_offsets_[ring_id],
+           ring_data_.data() + ring_offsets_[ring_id + 1], r);
+  };
+
+  multi_polygon mp;
+  auto it = polygon_rings_.begin() + polygon_offsets_[id];
+  auto const num_polygons = *it++;
+  mp.resize(num_polygons);
+  for (auto& pol : mp) {
+    auto const num_rings = *it++;
+    read_ring(*it++, pol.outer());
+    pol.inners().resize(num_rings - 1);
+    for (auto& inner : pol.inners()) {
+      read_ring(*it++, inner);
+    }
+  }
+  return mp;
+}
+
+size_t polygon_store::byte_size() const {
+  return ring_data_.size() + ring_offsets_.size() * sizeof(uint64_t) +
+         polygon_rings_.size() * sizeof(uint32_t) +
+         polygon_offsets_.size() * sizeof(uint64_t);
+}
+
+bool polygon_store::envelope(index_t const id, box& result) const {
+  bg::assign_inverse(result);
+  auto has_edge = false;
+  auto points = std::vector<point>();
+  auto it = polygon_rings_.begin() + polygon_offsets_[id];
+  auto const num_polygons = *it++;
+  for (auto p = 0U; p != num_polygons; ++p) {
+    auto const num_rings = *it++;
+    for (auto r = 0U; r != num_rings; ++r) {
+      read_ring(*it++, points);
+      has_edge = has_edge || points.size() >= 2;
+      for (auto const& point : points) {
+        bg::expand(result, point);
+      }
+    }
+  }
+  return has_edge;
+}
+
+void polygon_store::simplify(int32_t const tolerance) {
+  if (tolerance <= 0) {
+    return;
+  }
+  auto const num_rings = static_cast<uint32_t>(ring_offsets_.size() - 1);
+
+  // vertices of a ring without the closing point
+  auto points = std::vector<point>();
+  auto const read_cycle = [&](uint32_t const ring_id) {
+    read_ring(ring_id, points);
+    if (points.size() > 1 && key(points.front()) == key(points.back())) {
+      points.pop_back();
+    }
+  };
+
+  // junctions: vertices with more than one distinct pair of neighbours
+  auto junctions = std::vector<uint64_t>();
+  {
+    auto neighbours = std::vector<std::array<uint64_t, 3>>();
+    for (auto r = 0U; r != num_rings; ++r) {
+      read_cycle(r);
+      auto const n = points.size();
+      for (auto i = size_t(0); n >= 3 && i != n; ++i) {
+        auto const prev = key(points[(i + n - 1) % n]);
+        auto const next = key(points[(i + 1) % n]);
+        neighbours.push_back(
+            {key(points[i]), std::min(prev, next), std::max(prev, next)});
+      }
+    }
+    std::sort(begin(neighbours), end(neighbours));
+    neighbours.erase(std::unique(begin(neighbours), end(neighbours)),
+                     end(neighbours));
+    for (auto i = size_t(1); i < neighbours.size(); ++i) {
+      auto const k = neighbours[i][0];
+      if (neighbours[i - 1][0] == k &&
+          (junctions.empty() || junctions.back() != k)) {
+        junctions.push_back(k);
+      }
+    }
+  }
+  auto const is_junction = [&](point const& p) {
+    return std::binary_search(begin(junctions), end(junctions), key(p));
+  };
+
+  // rings as sequences of arcs (id << 1 | reversed), rings with less than
+  // three vertices have none and are kept as they are; a ring without any
+  // junction is one closed arc starting at its smallest vertex, arcs are
+  // stored in a canonical direction to find shared ones
+  auto arcs = arc_store();
+  auto ring_arcs = std::vector<uint32_t>();
+  auto ring_arc_offsets = std::vector<uint64_t>{0};
+  auto arc = std::vector<point>();
+  auto starts = std::vector<size_t>();
+  for (auto r = 0U; r != num_rings; ++r) {
+    read_cycle(r);
+    auto const n = points.size();
+    starts.clear();
+    for (auto i = size_t(0); n >= 3 && i != n; ++i) {
+      if (is_junction(points[i])) {
+        starts.push_back(i);
+      }
+    }
+    if (n >= 3 && starts.empty()) {
+      starts.push_back(static_cast<size_t>(
+          std::min_element(begin(points), end(points),
+                           [](point const& a, point const& b) {
+                             return key(a) < key(b);
+                           }) -
+          begin(points)));
+    }
+    for (auto k = size_t(0); k != starts.size(); ++k) {
+      auto const from = starts[k];
+      auto const to = k + 1 == starts.size() ? starts[0] + n : starts[k + 1];
+      arc.clear();
+      for (auto i = from; i <= to; ++i) {
+        arc.push_back(points[i % n]);
+      }
+      auto const front = key(arc.front());
+      auto const back = key(arc.back());
+      auto const reversed =
+          front > back ||
+          (front == back && key(arc[1]) > key(arc[arc.size() - 2]));
+      if (reversed) {
+        std::reverse(begin(arc), end(arc));
+      }
+      ring_arcs.push_back((arcs.add(arc) << 1U) | (reversed ? 1U : 0U));
+    }
+    ring_arc_offsets.push_back(ring_arcs.size());
+  }
+  junctions = std::vector<uint64_t>();
+  arcs.index_ = sequence_index();
+
+  auto simplified = arc_store();
+  auto simplified_arc = std::vector<point>();
+  for (auto a = 0U; a != arcs.size(); ++a) {
+    arcs.get(a, arc);
+    douglas_peucker(arc, static_cast<double>(tolerance), simplified_arc);
+    encode(simplified_arc, simplified.data_);
+    simplified.offsets_.push_back(simplified.data_.size());
+  }
+
+  auto keep = std::vector<bool>(arcs.size(), false);
+  auto const build_ring = [&](uint32_t const ring_id,
+                              std::vector<point>& result) {
+    auto const first = ring_arc_offsets[ring_id];
+    auto const last = ring_arc_offsets[ring_id + 1];
+    if (first == last) {
+      read_ring(ring_id, result);
+      return;
+    }
+    result.clear();
+    for (auto i = first; i != last; ++i) {
+      auto const arc_id = ring_arcs[i] >> 1U;
+      (keep[arc_id] ? arcs : simplified).get(arc_id, arc);
+      if ((ring_arcs[i] & 1U) != 0U) {
+        std::reverse(begin(arc), end(arc));
+      }
+      result.insert(end(result), begin(arc) + (result.empty() ? 0 : 1),
+                    end(arc));
+    }
+  };
+
+  // polygons with a degenerated ring or intersections use the original
+  // arcs, which changes their neighbours as well: repeated until stable
+  auto const keep_arcs = [&](uint32_t const ring_id) {
+    auto changed = false;
+    for (auto i = ring_arc_offsets[ring_id]; i != ring_arc_offsets[ring_id + 1];
+         ++i) {
+      auto const arc_id = ring_arcs[i] >> 1U;
+      changed = changed || !keep[arc_id];
+      keep[arc_id] = true;
+    }
+    return changed;
+  };
+  auto changed = true;
+  auto pol = polygon();
+  while (changed) {
+    changed = false;
+    for (auto m = size_t(0); m + 1 < polygon_offsets_.size(); ++m) {
+      auto it = polygon_rings_.begin() + polygon_offsets_[m];
+      auto const num_polygons = *it++;
+      for (auto p = 0U; p != num_polygons; ++p) {
+        auto const num_rings_of_polygon = *it++;
+        auto const ring_ids = it;
+        it += num_rings_of_polygon;
+
+        auto all_kept = true;
+        for (auto r = ring_ids; r != it; ++r) {
+          for (auto i = ring_arc_offsets[*r]; i != ring_arc_offsets[*r + 1];
+               ++i) {
+            all_kept = all_kept && keep[ring_arcs[i] >> 1U];
+          }
+        }
+        if (all_kept) {
+          continue;
+        }
+
+        auto degenerated = false;
+        build_ring(*ring_ids, points);
+        pol.outer().assign(begin(points), end(points));
+        degenerated = degenerated || points.size() < 4;
+        pol.inners().resize(num_rings_of_polygon - 1);
+        for (auto r = size_t(1); r != num_rings_of_polygon; ++r) {
+          build_ring(ring_ids[r], points);
+          pol.inners()[r - 1].assign(begin(points), end(points));
+          degenerated = degenerated || points.size() < 4;
+        }
+        if (degenerated || bg::intersects(pol)) {
+          for (auto r = ring_ids; r != it; ++r) {
+            changed = keep_arcs(*r) || changed;
+          }
+        }
+      }
+    }
+  }
+
+  auto data = std::vector<uint8_t>();
+  auto offsets = std::vector<uint64_t>{0};
+  ring_index_.clear();
+  for (auto r = 0U; r != num_rings; ++r) {
+    build_ring(r, points);
+    encode(points, data);
+    ring_index_[hash(data.data() + offsets.back(), data.data() + data.size())]
+        .push_back(r);
+    offsets.push_back(data.size());
+  }
+  ring_data_ = std::move(data);
+  ring_offsets_ = std::move(offsets);
+}
+
+}  // namespace address_typeahead
@@ -0,0 +1,123 @@
+#include "address-typeahead/prefix_index.h"
+
+#include <algorithm>
+#include <numeric>
+
+namespace address_typeahead {
+
+namespace {
+
+constexpr auto const NUM_SLOTS = size_t(256) + 256 * 256;
+
+size_t slot(std::string_view const prefix) {
+  auto const first = static_cast<unsigned char>(prefix[0]);
+  if (prefix.size() == 1) {
+    return first;
+  }
+  return 256 + first * 256U + static_cast<unsigned char>(prefix[1]);
+}
+
+}  // namespace
+
+prefix_index::prefix_index(std::vector<std::string> const& strings,
+                           std::vector<float> const& scores)
+    : scores_(scores) {
+  sorted_.resize(strings.size());
+  std::iota(begin(sorted_), end(sorted_), 0U);
+  std::sort(begin(sorted_), end(sorted_),
+            [&](index_t const a, index_t const b) {
+              return strings[a] < strings[b] ||
+                     (strings[a] == strings[b] && a < b);
+            });
+
+  offsets_.reserve(sorted_.size() + 1);
+  for (auto const idx : sorted_) {
+    offsets_.emplace_back(chars_.size());
+    chars_ += strings[idx];
+  }
+  offsets_.emplace_back(chars_.size());
+
+  // strings sharing a prefix are consecutive in sorted order and the ranges
+  // of all one byte prefixes come before the two byte prefixes
+  top_offsets_.resize(NUM_SLOTS + 1);
+  auto next_slot = size_t(0);
+  for (auto const length : {size_t(1), size_t(2)}) {
+    for (auto i = size_t(0); i != sorted_.size();) {
+      if (get(i).size() < length) {
+        ++i;
+        continue;
+      }
+      auto const prefix = get(i).substr(0, length);
+      auto j = i + 1;
+      while (j != sorted_.size() && get(j).substr(0, length) == prefix) {
+        ++j;
+      }
+
+      auto const s = slot(prefix);
+      for (; next_slot <= s; ++next_slot) {
+        top_offsets_[next_slot] = static_cast<uint32_t>(top_.size());
+      }
+      top_k(i, j, TOP_K, top_);
+      i = j;
+    }
+  }
+  for (; next_slot != top_offsets_.size(); ++next_slot) {
+    top_offsets_[next_slot] = static_cast<uint32_t>(top_.size());
+  }
+}
+
+std::vector<index_t> prefix_index::match(std::string_view const prefix,
+                                         size_t const count) const {
+  auto result = std::vector<index_t>();
+  if (prefix.empty() || count == 0) {
+    return result;
+  }
+
+  if (prefix.size() <= 2 && count <= TOP_K) {
+    auto const s = slot(prefix);
+    auto const from = top_offsets_[s];
+    auto const to = std::min(top_offsets_[s + 1],
+                             static_cast<uint32_t>(from + count));
+    result.assign(begin(top_) + from, begin(top_) + to);
+    return result;
+  }
+
+  auto first = size_t(0);
+  auto last = sorted_.size();
+  while (first != last) {
+    auto const mid = first + (last - first) / 2;
+    if (get(mid) < prefix) {
+      first = mid + 1;
+    } else {
+      last = mid;
+    }
+  }
+  last = first;
+  while (last != sorted_.size() &&
+         get(last).substr(0, prefix.size()) == prefix) {
+    ++last;
+  }
+  top_k(first, last, count, result);
+  return result;
+}
+
+std::string_view prefix_index::get(size_t const sorted_idx) const {
+  return std::string_view(chars_).substr(
+      offsets_[sorted_idx], offsets_[sorted_idx + 1] - offsets_[sorted_idx]);
+}
+
+void prefix_index::top_k(size_t const from, size_t const to,
+                         size_t const count,
+                         std::vector<index_t>& result) const {
+  auto candidates =
+      std::vector<index_t>(begin(sorted_) + from, begin(sorted_) + to);
+  auto const by_score = [&](index_t const a, index_t const b) {
+    return scores_[a] > scores_[b] || (scores_[a] == scores_[b] && a < b);
+  };
+  auto const n = std::min(count, candidates.size());
+  std::partial_sort(begin(candidates), begin(candidates) + n, end(candidates),
+                    by_score);
+  result.insert(end(result), begin(candidates), begin(candidates) + n);
+}
+
+}  // namespace address_typeahead
@@ -0,0 +1,113 @@
+#include "address-typeahead/prepared_polygon.h"
+
+#include <algorithm>
+
+namespace address_typeahead {
+
+constexpr auto const EDGES_PER_STRIP = size_t(4);
+constexpr auto const MAX_STRIPS = size_t(1) << 16U;
+
+prepared_polygon::prepared_polygon(multi_polygon const& mp) {
+  auto edges = std::vector<uint32_t>();
+  auto const add_ring = [&](ring const& r) {
+    if (r.size() < 2) {
+      return;
+    }
+    auto const first = static_cast<uint32_t>(vertices_.size());
+    vertices_.insert(vertices_.end(), r.begin(), r.end());
+    if (!bg::equals(r.front(), r.back())) {
+      vertices_.push_back(r.front());
+    }
+    for (auto i = first; i + 1 < vertices_.size(); ++i) {
+      edges.push_back(i);
+    }
+  };
+
+  for (auto const& pol : mp) {
+    add_ring(pol.outer());
+    for (auto const& inner : pol.inners()) {
+      add_ring(inner);
+    }
+  }
+
+  if (edges.empty()) {
+    return;
+  }
+  envelope_ = bg::return_envelope<box>(mp);
+
+  auto const min_y = static_cast<int64_t>(envelope_.min_corner().get<1>());
+  auto const max_y = static_cast<int64_t>(envelope_.max_corner().get<1>());
+  auto const target_strips =
+      std::clamp(edges.size() / EDGES_PER_STRIP, size_t(1), MAX_STRIPS);
+  strip_height_ = (max_y - min_y) / static_cast<int64_t>(target_strips) + 1;
+
+  auto const strip_of = [&](int32_t const y) {
+    return static_cast<size_t>((y - min_y) / strip_height_);
+  };
+  auto const strip_range = [&](uint32_t const e) {
+    auto const y0 = vertices_[e].get<1>();
+    auto const y1 = vertices_[e + 1].get<1>();
+    return std::make_pair(strip_of(std::min(y0, y1)),
+                          strip_of(std::max(y0, y1)));
+  };
+
+  // counting sort of the edges into the strips they overlap
+  strip_offsets_.assign(strip_of(envelope_.max_corner().get<1>()) + 2, 0);
+  for (auto const e : edges) {
+    auto const [from, to] = strip_range(e);
+    for (auto s = from; s <= to; ++s) {
+      ++strip_offsets_[s + 1];
+    }
+  }
+  for (size_t s = 1; s != strip_offsets_.size(); ++s) {
+    strip_offsets_[s] += strip_offsets_[s - 1];
+  }
+
+  strip_edges_.resize(strip_offsets_.back());
+  auto insert_pos = std::vector<uint32_t>(strip_offsets_.begin(),
+                                          std::prev(strip_offsets_.end()));
+  for (auto const e : edges) {
+    auto const [from, to] = strip_range(e);
+    for (auto s = from; s <= to; ++s) {
+      strip_edges_[insert_pos[s]++] = e;
+    }
+  }
+}
+
+bool prepared_polygon::within(point const& p) const {
+  if (strip_offsets_.empty() || !bg::covered_by(p, envelope_)) {
+    return false;
+  }
+
+  auto const px = static_cast<int64_t>(p.get<0>());
+  auto const py = static_cast<int64_t>(p.get<1>());
+  auto const strip = static_cast<size_t>(
+      (py - envelope_.min_corner().get<1>()) / strip_height_);
+
+  // ray casting to the right of p, all products fit into int64 for osm
+  // coordinates (|dx| < 2^32, |dy| < 2^31)
+  auto inside = false;
+  for (auto i = strip_offsets_[strip]; i != strip_offsets_[strip + 1]; ++i) {
+    auto const e = strip_edges_[i];
+    auto const ax = static_cast<int64_t>(vertices_[e].get<0>());
+    auto const ay = static_cast<int64_t>(vertices_[e].get<1>());
+    auto const bx = static_cast<int64_t>(vertices_[e + 1].get<0>());
+    auto const by = static_cast<int64_t>(vertices_[e + 1].get<1>());
+
+    auto const lhs = (bx - ax) * (py - ay);
+    auto const rhs = (px - ax) * (by - ay);
+    if (lhs == rhs && px >= std::min(ax, bx) && px <= std::max(ax, bx) &&
+        py >= std::min(ay, by) && py <= std::max(ay, by)) {
+      return false;
+    }
+
+    if ((ay > py) != (by > py)) {
+      if (by > ay ? rhs < lhs : rhs > lhs) {
+        inside = !inside;
+      }
+    }
+  }
+  return inside;
+}
+
+}  // namespace address_typeahead
@@ -0,0 +1,81 @@
+#include "address-typeahead/query_tokenizer.h"
+
+#include <limits>
+
+namespace address_typeahead {
+
+namespace {
+
+bool is_space(char const c) {
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+bool is_separator(char const c) { return c == ',' || c == ';'; }
+
+bool is_digit(char const c) { return c >= '0' && c <= '9'; }
+
+bool is_letter(char const c) {
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
+
+query_token classify(std::string_view const str) {
+  if (str == ".") {
+    return query_token{str, token_type::HOUSE_NUMBER};
+  }
+
+  auto digits = size_t(0);
+  auto value = uint64_t(0);
+  while (digits != str.size() && is_digit(str[digits])) {
+    value = value * 10 + static_cast<uint64_t>(str[digits] - '0');
+    ++digits;
+    if (value > std::numeric_limits<index_t>::max()) {
+      return query_token{str, token_type::WORD};
+    }
+  }
+
+  if (digits >= 5 && digits == str.size()) {
+    return query_token{str, token_type::POSTCODE, static_cast<index_t>(value)};
+  }
+  if (digits >= 1 && digits <= 4) {
+    auto letters = digits;
+    while (letters != str.size() && is_letter(str[letters])) {
+      ++letters;
+    }
+    if (letters == str.size()) {
+      return query_token{str, token_type::HOUSE_NUMBER};
+    }
+  }
+  return query_token{str, token_type::WORD};
+}
+
+}  // namespace
+
+void tokenize(std::string_view const query,
+              std::pmr::vector<query_token>& tokens) {
+  tokens.clear();
+  auto token_start = size_t(0);
+  auto const finish_token = [&](size_t const end) {
+    if (end != token_start) {
+      tokens.emplace_back(
+          classify(query.substr(token_start, end - token_start)));
+    }
+  };
+
+  for (auto i = size_t(0); i != query.size(); ++i) {
+    auto const c = query[i];
+    if (is_space(c)) {
+      finish_token(i);
+      token_start = i + 1;
+    } else if (is_separator(c)) {
+      finish_token(i);
+      if (tokens.empty() || tokens.back().type_ != token_type::SEPARATOR) {
+        tokens.emplace_back(
+            query_token{query.substr(i, 1), token_type::SEPARATOR});
+      }
+      token_start = i + 1;
+    }
+  }
+  finish_token(query.size());
+}
+
+}  // namespace address_typeahead
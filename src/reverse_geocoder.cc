@@ -0,0 +1,128 @@
+#include "address-typeahead/reverse_geocoder.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "address-typeahead/interpolation.h"
+
+namespace address_typeahead {
+
+namespace {
+
+constexpr auto const EARTH_RADIUS = 6371000.0;
+constexpr auto const TO_RAD = 3.14159265358979323846 / 180.0;
+
+reverse_geocoder::sphere_point to_sphere(double const lat, double const lon) {
+  auto const phi = lat * TO_RAD;
+  auto const lambda = lon * TO_RAD;
+  return reverse_geocoder::sphere_point(std::cos(phi) * std::cos(lambda),
+                                        std::cos(phi) * std::sin(lambda),
+                                        std::sin(phi));
+}
+
+reverse_geocoder::sphere_point to_sphere(coordinates const& c) {
+  return to_sphere(c.lat_ / 10000000.0, c.lon_ / 10000000.0);
+}
+
+std::vector<reverse_geocoder::value> get_values(
+    typeahead_context const& context,
+    std::vector<reverse_geocoder::entry>& entries) {
+  auto values = std::vector<reverse_geocoder::value>();
+  auto const add = [&](coordinates const& c, index_t const id,
+                       index_t const house_number,
+                       uint32_t const interpolated_number) {
+    values.emplace_back(to_sphere(c), static_cast<uint32_t>(entries.size()));
+    entries.emplace_back(
+        reverse_geocoder::entry{id, house_number, interpolated_number});
+  };
+
+  for (auto i = size_t(0); i != context.places_.size(); ++i) {
+    add(context.places_[i].coordinates_, static_cast<index_t>(i),
+        NO_HOUSE_NUMBER, 0U);
+  }
+  for (auto i = size_t(0); i != context.streets_.size(); ++i) {
+    auto const& house_numbers = context.streets_[i].house_numbers_;
+    for (auto j = size_t(0); j != house_numbers.size(); ++j) {
+      add(house_numbers[j].coordinates_,
+          static_cast<index_t>(context.places_.size() + i),
+          static_cast<index_t>(j), 0U);
+    }
+  }
+
+  // interpolated numbers of every street (interpolations are sorted by
+  // street), unless mapped or covered by another range of the street
+  auto numbers = std::vector<uint32_t>();
+  auto const& interpolations = context.interpolations_;
+  for (auto first = begin(interpolations); first != end(interpolations);) {
+    auto const id = first->id_;
+    auto const last = std::find_if(
+        first, end(interpolations),
+        [&](interpolation const& i) { return i.id_ != id; });
+
+    numbers.clear();
+    if (context.is_street(id)) {
+      for (auto const& hn :
+           context.streets_[id - context.places_.size()].house_numbers_) {
+        auto number = uint32_t(0);
+        if (parse_house_number(context.house_numbers_[hn.hn_idx_], number)) {
+          numbers.emplace_back(number);
+        }
+      }
+    }
+    std::sort(begin(numbers), end(numbers));
+
+    for (auto i = first; i != last; ++i) {
+      auto const covered = numbers.size();
+      for_each_number(*i, [&](uint32_t const number) {
+        auto c = coordinates();
+        if (!std::binary_search(begin(numbers), begin(numbers) + covered,
+                                number) &&
+            interpolate(*i, number, c)) {
+          numbers.emplace_back(number);
+          add(c, id, NO_HOUSE_NUMBER, number);
+        }
+      });
+      std::inplace_merge(begin(numbers), begin(numbers) + covered,
+                         end(numbers));
+    }
+    first = last;
+  }
+  return values;
+}
+
+}  // namespace
+
+// constructing the rtree from the whole range uses the packing algorithm
+reverse_geocoder::reverse_geocoder(typeahead_context const& context)
+    : num_places_(context.places_.size()),
+      rtree_(get_values(context, entries_)) {}
+
+std::vector<reverse_result> reverse_geocoder::lookup(double const lat,
+                                                     double const lon,
+                                                     size_t const count) const {
+  auto result = std::vector<reverse_result>();
+  if (count == 0) {
+    return result;
+  }
+
+  auto const p = to_sphere(lat, lon);
+  for (auto it = rtree_.qbegin(bgi::nearest(p, static_cast<unsigned>(count)));
+       it != rtree_.qend(); ++it) {
+    // chord length -> great circle distance
+    auto const chord = bg::distance(p, it->first);
+    auto const& e = entries_[it->second];
+    auto const interpolated =
+        e.house_number_ == NO_HOUSE_NUMBER && e.id_ >= num_places_;
+    result.emplace_back(reverse_result{
+        e.id_, e.house_number_,
+        2.0 * EARTH_RADIUS * std::asin(std::min(1.0, chord / 2.0)),
+        interpolated, e.interpolated_number_});
+  }
+  std::sort(begin(result), end(result),
+            [](reverse_result const& a, reverse_result const& b) {
+              return a.distance_ < b.distance_;
+            });
+  return result;
+}
+
+}  // namespace address_typeahead
@@ -0,0 +1,218 @@
+#include "address-typeahead/score_kernels.h"
+
+// SSE2 is part of x86-64, AVX2 is detected at runtime
+#if defined(__x86_64__) || defined(_M_X64)
+#define AT_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// MSVC compiles intrinsics of every instruction set without target flags
+#if defined(AT_X86) && !defined(_MSC_VER)
+#define AT_TARGET(arch) __attribute__((target(arch)))
+#else
+#define AT_TARGET(arch)
+#endif
+
+namespace address_typeahead {
+
+namespace {
+
+void select_geq_scalar(float const* values, size_t const n,
+                       float const threshold, std::vector<uint32_t>& out) {
+  for (auto i = size_t(0); i != n; ++i) {
+    if (values[i] >= threshold) {
+      out.push_back(static_cast<uint32_t>(i));
+    }
+  }
+}
+
+void scale_scalar(float* values, size_t const n, float const factor) {
+  for (auto i = size_t(0); i != n; ++i) {
+    values[i] *= factor;
+  }
+}
+
+void multiply_add_scalar(float* acc, float const* values, size_t const n,
+                         float const weight) {
+  for (auto i = size_t(0); i != n; ++i) {
+    acc[i] += values[i] * weight;
+  }
+}
+
+#ifdef AT_X86
+
+// bit i of mask set: append offset + i
+void append_mask(unsigned mask, size_t const offset,
+                 std::vector<uint32_t>& out) {
+  while (mask != 0) {
+#ifdef _MSC_VER
+    unsigned long bit;  // NOLINT
+    _BitScanForward(&bit, mask);
+#else
+    auto const bit = static_cast<unsigned>(__builtin_ctz(mask));
+#endif
+    out.push_back(static_cast<uint32_t>(offset + bit));
+    mask &= mask - 1;
+  }
+}
+
+AT_TARGET("sse2")
+void select_geq_sse2(float const* values, size_t const n,
+                     float const threshold, std::vector<uint32_t>& out) {
+  auto const t = _mm_set1_ps(threshold);
+  auto i = size_t(0);
+  for (; i + 4 <= n; i += 4) {
+    auto const mask = static_cast<unsigned>(
+        _mm_movemask_ps(_mm_cmpge_ps(_mm_loadu_ps(values + i), t)));
+    append_mask(mask, i, out);
+  }
+  for (; i != n; ++i) {
+    if (values[i] >= threshold) {
+      out.push_back(static_cast<uint32_t>(i));
+    }
+  }
+}
+
+AT_TARGET("sse2")
+void scale_sse2(float* values, size_t const n, float const factor) {
+  auto const f = _mm_set1_ps(factor);
+  auto i = size_t(0);
+  for (; i + 4 <= n; i += 4) {
+    _mm_storeu_ps(values + i, _mm_mul_ps(_mm_loadu_ps(values + i), f));
+  }
+  for (; i != n; ++i) {
+    values[i] *= factor;
+  }
+}
+
+AT_TARGET("sse2")
+void multiply_add_sse2(float* acc, float const* values, size_t const n,
+                       float const weight) {
+  auto const w = _mm_set1_ps(weight);
+  auto i = size_t(0);
+  for (; i + 4 <= n; i += 4) {
+    auto const product = _mm_mul_ps(_mm_loadu_ps(values + i), w);
+    _mm_storeu_ps(acc + i, _mm_add_ps(_mm_loadu_ps(acc + i), product));
+  }
+  for (; i != n; ++i) {
+    acc[i] += values[i] * weight;
+  }
+}
+
+AT_TARGET("avx2")
+void select_geq_avx2(float const* values, size_t const n,
+                     float const threshold, std::vector<uint32_t>& out) {
+  auto const t = _mm256_set1_ps(threshold);
+  auto i = size_t(0);
+  for (; i + 8 <= n; i += 8) {
+    auto const mask = static_cast<unsigned>(_mm256_movemask_ps(
+        _mm256_cmp_ps(_mm256_loadu_ps(values + i), t, _CMP_GE_OQ)));
+    append_mask(mask, i, out);
+  }
+  for (; i != n; ++i) {
+    if (values[i] >= threshold) {
+      out.push_back(static_cast<uint32_t>(i));
+    }
+  }
+}
+
+AT_TARGET("avx2")
+void scale_avx2(float* values, size_t const n, float const factor) {
+  auto const f = _mm256_set1_ps(factor);
+  auto i = size_t(0);
+  for (; i + 8 <= n; i += 8) {
+    _mm256_storeu_ps(values + i,
+                     _mm256_mul_ps(_mm256_loadu_ps(values + i), f));
+  }
+  for (; i != n; ++i) {
+    values[i] *= factor;
+  }
+}
+
+// multiply and add separately (no fma) to match the scalar results
+AT_TARGET("avx2")
+void multiply_add_avx2(float* acc, float const* values, size_t const n,
+                       float const weight) {
+  auto const w = _mm256_set1_ps(weight);
+  auto i = size_t(0);
+  for (; i + 8 <= n; i += 8) {
+    auto const product = _mm256_mul_ps(_mm256_loadu_ps(values + i), w);
+    _mm256_storeu_ps(acc + i,
+                     _mm256_add_ps(_mm256_loadu_ps(acc + i), product));
+  }
+  for (; i != n; ++i) {
+    acc[i] += values[i] * weight;
+  }
+}
+
+bool cpu_supports_avx2() {
+#ifdef _MSC_VER
+  int info[4];
+  __cpuid(info, 0);
+  if (info[0] < 7) {
+    return false;
+  }
+  __cpuid(info, 1);
+  auto const os_saves_ymm = (info[2] & (1 << 27)) != 0 &&  // OSXSAVE
+                            (_xgetbv(0) & 0x6) == 0x6;
+  __cpuidex(info, 7, 0);
+  return os_saves_ymm && (info[1] & (1 << 5)) != 0;
+#else
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2") != 0;
+#endif
+}
+
+#endif
+
+}  // namespace
+
+char const* to_str(simd_level const level) {
+  switch (level) {
+    case simd_level::SCALAR: return "scalar";
+    case simd_level::SSE2: return "sse2";
+    case simd_level::AVX2: return "avx2";
+  }
+  return "";
+}
+
+simd_level max_simd_level() {
+#ifdef AT_X86
+  static auto const level =
+      cpu_supports_avx2() ? simd_level::AVX2 : simd_level::SSE2;
+  return level;
+#else
+  return simd_level::SCALAR;
+#endif
+}
+
+score_kernels const& get_score_kernels(simd_level const level) {
+  static auto const scalar = score_kernels{
+      select_geq_scalar, scale_scalar, multiply_add_scalar};
+#ifdef AT_X86
+  static auto const sse2 =
+      score_kernels{select_geq_sse2, scale_sse2, multiply_add_sse2};
+  static auto const avx2 =
+      score_kernels{select_geq_avx2, scale_avx2, multiply_add_avx2};
+
+  auto const max_level = max_simd_level();
+  if (level == simd_level::AVX2 && max_level == simd_level::AVX2) {
+    return avx2;
+  } else if (level != simd_level::SCALAR) {
+    return sse2;
+  }
+#else
+  (void)level;
+#endif
+  return scalar;
+}
+
+score_kernels const& get_score_kernels() {
+  static auto const& kernels = get_score_kernels(max_simd_level());
+  return kernels;
+}
+
+}  // namespace address_typeahead
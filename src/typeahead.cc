@@ -1,12 +1,73 @@
 #include "address-typeahead/typeahead.h"
 
 #include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <limits>
+#include <memory_resource>
+#include <mutex>
+#include <numeric>
+#include <optional>
 #include <utility>
 
+#include "address-typeahead/importance.h"
+#include "address-typeahead/normalize.h"
+#include "address-typeahead/parallel_for.h"
+#include "address-typeahead/score_kernels.h"
+
 using namespace guess;
 
 namespace address_typeahead {
 
+constexpr auto const INITIAL_ARENA_SIZE = size_t(64) * 1024;
+
+// score bounds of the first phase are inflated by this factor: they sum up
+// the similarities in another order than the scores
+constexpr auto const BOUND_SLACK = 1.0001F;
+
+// upstream of the query arena, counts the bytes the arena lacked
+struct overflow_counter : public std::pmr::memory_resource {
+  void* do_allocate(size_t const bytes, size_t const alignment) override {
+    overflow_ += bytes;
+    return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+  }
+
+  void do_deallocate(void* p, size_t const bytes,
+                     size_t const alignment) override {
+    std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+  }
+
+  bool do_is_equal(
+      std::pmr::memory_resource const& other) const noexcept override {
+    return this == &other;
+  }
+
+  size_t overflow_ = 0;
+};
+
+// position of the bit of an area level
+size_t level_bit(uint32_t const level) {
+  auto bit = size_t(0);
+  while (bit + 1 != NUM_LEVEL_BITS && (level >> bit) > 1U) {
+    ++bit;
+  }
+  return bit;
+}
+
+// calls fn with every alias of id, aliases are sorted by id
+template <typename Fn>
+void for_each_alias(std::vector<alias> const& aliases, index_t const id,
+                    Fn&& fn) {
+  auto it = std::lower_bound(
+      begin(aliases), end(aliases), id,
+      [](alias const& a, index_t const other) { return a.id_ < other; });
+  for (; it != end(aliases) && it->id_ == id; ++it) {
+    fn(*it);
+  }
+}
+
+// area guesser entries: one per area followed by one per area alias
 std::vector<std::pair<std::string, float>> get_names(
     typeahead_context const& context, bool const areas) {
   if (areas) {
@@ -14,41 +75,227 @@ std::vector<std::pair<std::string, float>> get_names(
     result.reserve(context.areas_.size());
     for (auto const& a : context.areas_) {
       if (a.level_ != POSTCODE) {
-        result.emplace_back(context.area_names_[a.name_idx_], a.popularity_);
+        result.emplace_back(context.area_name_keys_[a.name_idx_],
+                            a.popularity_);
       } else {
         result.emplace_back("", 0.0F);
       }
     }
+    for (auto const& a : context.area_aliases_) {
+      result.emplace_back(context.area_name_keys_[a.name_idx_],
+                          context.areas_[a.id_].popularity_);
+    }
     return result;
   }
 
+  // names are weighted by the most important place / street with the name
+  // (or alias)
   auto result = std::vector<std::pair<std::string, float>>();
-  result.reserve(context.names_.size());
-  for (auto const& name : context.names_) {
-    result.emplace_back(name, 1.0F);
+  result.reserve(context.name_keys_.size());
+  for (auto const& key : context.name_keys_) {
+    result.emplace_back(key, 1.0F);
+  }
+  for (auto i = size_t(0); i != context.importance_.size(); ++i) {
+    auto& weight = result[context.get_name_id(static_cast<index_t>(i))].second;
+    weight = std::max(weight, context.importance_[i]);
+  }
+  for (auto const& a : context.aliases_) {
+    auto& weight = result[a.name_idx_].second;
+    weight = std::max(weight, context.importance_[a.id_]);
   }
   return result;
 }
 
-typeahead::typeahead(typeahead_context context)
-    : context_(std::move(context)),
-      place_guesser_(get_names(context_, false)),
-      area_guesser_(get_names(context_, true)) {
+// heap bytes of get_names(context, areas), computed without building it
+size_t get_names_bytes(typeahead_context const& context, bool const areas) {
+  using entry = std::pair<std::string, float>;
+  if (areas) {
+    auto bytes = (context.areas_.size() + context.area_aliases_.size()) *
+                 sizeof(entry);
+    for (auto const& a : context.areas_) {
+      if (a.level_ != POSTCODE) {
+        bytes += heap_bytes(context.area_name_keys_[a.name_idx_]);
+      }
+    }
+    for (auto const& a : context.area_aliases_) {
+      bytes += heap_bytes(context.area_name_keys_[a.name_idx_]);
+    }
+    return bytes;
+  }
+
+  auto bytes = context.name_keys_.size() * sizeof(entry);
+  for (auto const& key : context.name_keys_) {
+    bytes += heap_bytes(key);
+  }
+  return bytes;
+}
+
+std::vector<std::pair<std::string, float>> get_names(
+    typeahead_context const& context, bool const areas,
+    match_engine const engine, match_engine const required) {
+  if (engine != required) {
+    return std::vector<std::pair<std::string, float>>();
+  }
+  return get_names(context, areas);
+}
+
+// contexts extracted by older versions lack the precomputed data
+typeahead_context prepare_context(typeahead_context context) {
+  if (context.name_keys_.size() != context.names_.size() ||
+      context.area_name_keys_.size() != context.area_names_.size()) {
+    add_search_keys(context);
+  }
+  if (context.importance_.size() !=
+      context.places_.size() + context.streets_.size()) {
+    add_importance(context);
+  }
+  return context;
+}
+
+// context of the places / streets ids (ascending) without house numbers:
+// names, areas and aliases are reduced to the ones they reference (the
+// order of the kept ones is unchanged, sorted lists stay sorted)
+typeahead_context sub_context(typeahead_context const& context,
+                              std::vector<index_t> const& ids) {
+  auto const renumber = [](std::vector<index_t>& map) {
+    auto next = index_t(0);
+    for (auto& idx : map) {
+      idx = idx == 0 ? std::numeric_limits<index_t>::max() : next++;
+    }
+  };
+
+  auto name_map = std::vector<index_t>(context.names_.size(), 0);
+  auto area_map = std::vector<index_t>(context.areas_.size(), 0);
+  auto is_hot = std::vector<bool>(context.importance_.size(), false);
+  for (auto const id : ids) {
+    is_hot[id] = true;
+    name_map[context.get_name_id(id)] = 1;
+    for (auto const area_id : context.get_area_ids(id)) {
+      area_map[area_id] = 1;
+    }
+  }
+  for (auto const& a : context.aliases_) {
+    if (is_hot[a.id_]) {
+      name_map[a.name_idx_] = 1;
+    }
+  }
+  renumber(name_map);
+  renumber(area_map);
+
+  auto area_name_map = std::vector<index_t>(context.area_names_.size(), 0);
+  for (auto i = size_t(0); i != context.areas_.size(); ++i) {
+    auto const& a = context.areas_[i];
+    if (area_map[i] != std::numeric_limits<index_t>::max() &&
+        a.level_ != POSTCODE) {
+      area_name_map[a.name_idx_] = 1;
+    }
+  }
+  for (auto const& a : context.area_aliases_) {
+    if (area_map[a.id_] != std::numeric_limits<index_t>::max()) {
+      area_name_map[a.name_idx_] = 1;
+    }
+  }
+  renumber(area_name_map);
+
+  typeahead_context sub;
+  sub.population_sum_ = context.population_sum_;
+  for (auto i = size_t(0); i != context.names_.size(); ++i) {
+    if (name_map[i] != std::numeric_limits<index_t>::max()) {
+      sub.names_.emplace_back(context.names_[i]);
+      sub.name_keys_.emplace_back(context.name_keys_[i]);
+    }
+  }
+  for (auto i = size_t(0); i != context.area_names_.size(); ++i) {
+    if (area_name_map[i] != std::numeric_limits<index_t>::max()) {
+      sub.area_names_.emplace_back(context.area_names_[i]);
+      sub.area_name_keys_.emplace_back(context.area_name_keys_[i]);
+    }
+  }
+  for (auto i = size_t(0); i != context.areas_.size(); ++i) {
+    if (area_map[i] != std::numeric_limits<index_t>::max()) {
+      auto a = context.areas_[i];
+      if (a.level_ != POSTCODE) {
+        a.name_idx_ = area_name_map[a.name_idx_];
+      }
+      sub.areas_.emplace_back(a);
+    }
+  }
+
+  auto const map_areas = [&](std::vector<index_t> const& areas) {
+    auto result = std::vector<index_t>();
+    result.reserve(areas.size());
+    for (auto const area_id : areas) {
+      result.emplace_back(area_map[area_id]);
+    }
+    return result;
+  };
+  auto id_map = std::vector<index_t>(is_hot.size());
+  for (auto const id : ids) {
+    id_map[id] = static_cast<index_t>(sub.importance_.size());
+    sub.importance_.emplace_back(context.importance_[id]);
+    if (context.is_place(id)) {
+      auto const& p = context.places_[id];
+      sub.places_.emplace_back(location{name_map[p.name_idx_], p.coordinates_,
+                                        map_areas(p.areas_)});
+    } else {
+      auto const& str = context.streets_[id - context.places_.size()];
+      sub.streets_.emplace_back(
+          street{name_map[str.name_idx_], {}, map_areas(str.areas_)});
+    }
+  }
+  sub.house_numbers_ = {""};
+
+  for (auto const& a : context.aliases_) {
+    if (is_hot[a.id_]) {
+      sub.aliases_.emplace_back(alias{id_map[a.id_], name_map[a.name_idx_]});
+    }
+  }
+  for (auto const& a : context.area_aliases_) {
+    if (area_map[a.id_] != std::numeric_limits<index_t>::max()) {
+      sub.area_aliases_.emplace_back(
+          alias{area_map[a.id_], area_name_map[a.name_idx_]});
+    }
+  }
+  return sub;
+}
+
+typeahead::typeahead(typeahead_context context, match_engine const engine)
+    : context_(prepare_context(std::move(context))),
+      engine_(engine),
+      place_guesser_(get_names(context_, false, engine, match_engine::GUESS)),
+      area_guesser_(get_names(context_, true, engine, match_engine::GUESS)),
+      place_index_(get_names(context_, false, engine, match_engine::NGRAM)),
+      area_index_(get_names(context_, true, engine, match_engine::NGRAM)),
+      scratch_pool_(std::make_unique<scratch_pool>()),
+      tier_counters_(std::make_unique<tier_counters>()),
+      async_executor_(std::make_unique<async_executor>()) {
 
   auto const i_max = context_.places_.size() + context_.streets_.size();
-  acc_.resize(i_max);
-  place_guess_to_index_.resize(place_guesser_.candidates_.size());
-  area_guess_to_index_.resize(area_guesser_.candidates_.size());
+  place_guess_to_index_.resize(context_.names_.size());
+  area_guess_to_index_.resize(context_.areas_.size());
 
+  auto name_scores = std::vector<float>(context_.names_.size());
   for (index_t i = 0; i != i_max; ++i) {
     place_guess_to_index_[context_.get_name_id(i)].emplace_back(i);
 
+    auto& name_score = name_scores[context_.get_name_id(i)];
+    name_score = std::max(name_score, context_.importance_[i]);
+
     auto const area_ids = context_.get_area_ids(i);
+    auto postcode_areas = size_t(0);
     for (auto const& area_id : area_ids) {
       auto const& a = context_.areas_[area_id];
       if (a.level_ != POSTCODE) {
         area_guess_to_index_[area_id].emplace_back(i);
+        auto& max_areas = max_level_areas_[level_bit(a.level_)];
+        max_areas = std::max(
+            max_areas,
+            static_cast<size_t>(std::count_if(
+                begin(area_ids), end(area_ids), [&](index_t const other) {
+                  return context_.areas_[other].level_ == a.level_;
+                })));
       } else {
+        ++postcode_areas;
         auto postcode_it = postcode_to_index_.find(a.name_idx_);
         if (postcode_it == postcode_to_index_.end()) {
           postcode_it =
@@ -58,6 +305,217 @@ typeahead::typeahead(typeahead_context context)
         postcode_it->second.emplace_back(i);
       }
     }
+    max_postcode_areas_ = std::max(max_postcode_areas_, postcode_areas);
+  }
+  for (auto const& a : context_.aliases_) {
+    place_guess_to_index_[a.name_idx_].emplace_back(a.id_);
+    name_scores[a.name_idx_] =
+        std::max(name_scores[a.name_idx_], context_.importance_[a.id_]);
+  }
+  prefix_index_ = prefix_index(context_.name_keys_, name_scores);
+  house_number_index_ = house_number_index(context_);
+
+  // most important entities first: lists can be cut after the first
+  // max_results entries
+  auto const by_importance = [&](index_t const a, index_t const b) {
+    return more_important(a, b);
+  };
+  for (auto& list : place_guess_to_index_) {
+    std::sort(begin(list), end(list), by_importance);
+  }
+  for (auto& list : area_guess_to_index_) {
+    std::sort(begin(list), end(list), by_importance);
+  }
+  for (auto& [postcode, list] : postcode_to_index_) {
+    std::sort(begin(list), end(list), by_importance);
+  }
+}
+
+void typeahead::guess_match(guess::guesser const& guesser,
+                            ngram_index const& index,
+                            std::string_view const str, size_t const count,
+                            std::pmr::vector<ngram_match>& result) const {
+  if (engine_ == match_engine::NGRAM) {
+    index.match(str, count, result);
+    return;
+  }
+
+  result.clear();
+  for (auto const& g : guesser.guess_match(std::string(str), count)) {
+    result.emplace_back(
+        ngram_match{static_cast<index_t>(g.index), g.cos_sim});
+  }
+}
+
+std::vector<index_t> typeahead::complete_prefix(
+    std::string const& prefix, size_t const max_results) const {
+  auto result = std::vector<index_t>();
+  for (auto const name_id :
+       prefix_index_.match(normalize(prefix), max_results)) {
+    for (auto const& p_idx : place_guess_to_index_[name_id]) {
+      if (result.size() == max_results) {
+        return result;
+      }
+      result.emplace_back(p_idx);
+    }
+  }
+  return result;
+}
+
+std::vector<house_number_match> typeahead::complete_house_number(
+    index_t const id, std::string const& prefix,
+    size_t const max_results) const {
+  if (!context_.is_street(id)) {
+    return std::vector<house_number_match>();
+  }
+  return house_number_index_.match(
+      context_, static_cast<index_t>(id - context_.places_.size()), prefix,
+      max_results);
+}
+
+void typeahead::build_hot_tier(hot_tier_options const& options) {
+  auto const num_entities = context_.places_.size() + context_.streets_.size();
+  auto frequency = std::vector<uint32_t>(num_entities, 0);
+  for (auto const id : options.query_log_) {
+    if (id < num_entities) {
+      ++frequency[id];
+    }
+  }
+
+  auto ids = std::vector<index_t>(num_entities);
+  std::iota(begin(ids), end(ids), 0U);
+  auto const size = std::min(options.size_, ids.size());
+  std::nth_element(begin(ids), begin(ids) + size, end(ids),
+                   [&](index_t const a, index_t const b) {
+                     return frequency[a] > frequency[b] ||
+                            (frequency[a] == frequency[b] &&
+                             more_important(a, b));
+                   });
+  ids.resize(size);
+  std::sort(begin(ids), end(ids));
+
+  auto tier = std::make_shared<hot_tier>();
+  tier->typeahead_ =
+      std::make_unique<typeahead>(sub_context(context_, ids), engine_);
+  tier->ids_ = std::move(ids);
+  tier->min_confidence_ = options.min_confidence_;
+  std::atomic_store(&hot_tier_, std::shared_ptr<hot_tier const>(tier));
+  tier_counters_->hot_hits_ = 0;
+  tier_counters_->fallbacks_ = 0;
+}
+
+tier_stats typeahead::get_tier_stats() const {
+  auto stats = tier_stats();
+  stats.hot_hits_ = tier_counters_->hot_hits_.load();
+  stats.fallbacks_ = tier_counters_->fallbacks_.load();
+  return stats;
+}
+
+std::unique_ptr<typeahead::query_scratch> typeahead::scratch_pool::take() {
+  {
+    std::lock_guard<std::mutex> const lock(mutex_);
+    if (!free_.empty()) {
+      auto scratch = std::move(free_.back());
+      free_.pop_back();
+      return scratch;
+    }
+  }
+  auto scratch = std::make_unique<query_scratch>();
+  scratch->arena_.resize(INITIAL_ARENA_SIZE);
+  return scratch;
+}
+
+void typeahead::scratch_pool::put_back(
+    std::unique_ptr<query_scratch> scratch) {
+  std::lock_guard<std::mutex> const lock(mutex_);
+  free_.emplace_back(std::move(scratch));
+}
+
+memory_report typeahead::memory_usage() const {
+  auto report = memory_report();
+  report.add("context_.", context_.memory_usage());
+  report.add("place_guess_to_index_", heap_bytes(place_guess_to_index_));
+  report.add("area_guess_to_index_", heap_bytes(area_guess_to_index_));
+  report.add("postcode_to_index_", heap_bytes(postcode_to_index_));
+
+  // the guessers are opaque, they are estimated by the strings they copy
+  if (engine_ == match_engine::GUESS) {
+    report.add("place_guesser_ (estimate)", get_names_bytes(context_, false));
+    report.add("area_guesser_ (estimate)", get_names_bytes(context_, true));
+  }
+  auto const index_bytes = [](ngram_index const& index) {
+    return heap_bytes(index.terms_) + heap_bytes(index.blocks_) +
+           heap_bytes(index.postings_) + heap_bytes(index.candidate_scores_);
+  };
+  report.add("place_index_", index_bytes(place_index_));
+  report.add("area_index_", index_bytes(area_index_));
+
+  report.add("prefix_index_",
+             heap_bytes(prefix_index_.sorted_) +
+                 heap_bytes(prefix_index_.offsets_) +
+                 heap_bytes(prefix_index_.chars_) +
+                 heap_bytes(prefix_index_.scores_) +
+                 heap_bytes(prefix_index_.top_offsets_) +
+                 heap_bytes(prefix_index_.top_));
+  report.add("house_number_index_",
+             heap_bytes(house_number_index_.keys_) +
+                 heap_bytes(house_number_index_.offsets_) +
+                 heap_bytes(house_number_index_.sorted_));
+
+  // scratches of running queries are not counted
+  auto scratch_bytes = size_t(0);
+  {
+    std::lock_guard<std::mutex> const lock(scratch_pool_->mutex_);
+    scratch_bytes = scratch_pool_->free_.capacity() *
+                    sizeof(std::unique_ptr<query_scratch>);
+    for (auto const& scratch : scratch_pool_->free_) {
+      scratch_bytes += sizeof(query_scratch) +
+                       heap_bytes(scratch->selected_) +
+                       heap_bytes(scratch->top_) +
+                       heap_bytes(scratch->arena_);
+    }
+  }
+  report.add("query scratch", scratch_bytes);
+
+  if (auto const hot = std::atomic_load(&hot_tier_); hot != nullptr) {
+    report.add("hot_tier_.", hot->typeahead_->memory_usage());
+    report.add("hot_ids_", heap_bytes(hot->ids_));
+  }
+  return report;
+}
+
+std::future<complete_result> typeahead::complete_async(
+    std::vector<std::string> strings, complete_options options,
+    std::shared_ptr<cancel_token const> token) const {
+  auto task = std::packaged_task<complete_result()>(
+      [this, strings = std::move(strings), options,
+       token = std::move(token)]() {
+        return complete(strings, options, token.get());
+      });
+  auto result = task.get_future();
+  async_executor_->submit(std::move(task));
+  return result;
+}
+
+void typeahead::async_executor::submit(
+    std::packaged_task<complete_result()> task) {
+  std::call_once(started_, [&]() {
+    for (auto i = 0U; i != default_num_threads(); ++i) {
+      workers_.emplace_back([&]() {
+        auto queued = std::packaged_task<complete_result()>();
+        while (queue_.pop(queued)) {
+          queued();
+        }
+      });
+    }
+  });
+  queue_.push(std::move(task));
+}
+
+typeahead::async_executor::~async_executor() {
+  queue_.close();
+  for (auto& worker : workers_) {
+    worker.join();
   }
 }
 
@@ -71,76 +529,234 @@ std::vector<index_t> typeahead::complete(
 std::vector<index_t> typeahead::complete(
     std::vector<std::string> const& strings,
     complete_options const& options) const {
-  if (strings.empty()) {
-    return std::vector<index_t>();
-  }
+  return complete(strings, options, nullptr).ids_;
+}
+
+// tokens of up to this many strings are kept on the stack
+constexpr auto const INLINE_TOKENS = size_t(32);
 
-  auto postcodes = std::vector<index_t>();
-  auto clean_strings = std::vector<std::string>();
+complete_result typeahead::complete(std::vector<std::string> const& strings,
+                                    complete_options const& options,
+                                    cancel_token const* token) const {
+  std::array<std::byte, INLINE_TOKENS * sizeof(query_token)> buffer;
+  std::pmr::monotonic_buffer_resource mem(buffer.data(), buffer.size());
+  auto tokens = std::pmr::vector<query_token>(&mem);
+  tokens.reserve(strings.size());
   for (auto const& str : strings) {
     auto const val = atol(str.c_str());
-    if (val == 0) {
-      clean_strings.emplace_back(str);
-    } else {
-      postcodes.emplace_back(val);
+    tokens.emplace_back(
+        val == 0 ? query_token{str, token_type::WORD}
+                 : query_token{str, token_type::POSTCODE,
+                               static_cast<index_t>(val)});
+  }
+  return complete_tokens(tokens, options, token);
+}
+
+complete_result typeahead::complete(std::string_view const query,
+                                    complete_options const& options,
+                                    cancel_token const* token) const {
+  std::array<std::byte, INLINE_TOKENS * sizeof(query_token)> buffer;
+  std::pmr::monotonic_buffer_resource mem(buffer.data(), buffer.size());
+  auto tokens = std::pmr::vector<query_token>(&mem);
+  tokenize(query, tokens);
+
+  auto house_number = std::string_view();
+  auto has_strings = false;
+  for (auto const& t : tokens) {
+    if (t.type_ == token_type::HOUSE_NUMBER) {
+      house_number = t.str_;
+    } else if (t.type_ != token_type::SEPARATOR) {
+      has_strings = true;
     }
   }
 
-  auto guess_strings = std::vector<std::string>();
+  auto result = has_strings ? complete_tokens(tokens, options, token)
+                            : complete_result();
+  result.house_number_ = house_number;
+  return result;
+}
+
+complete_result typeahead::complete_tokens(
+    std::pmr::vector<query_token> const& tokens,
+    complete_options const& options, cancel_token const* token,
+    float* confidence) const {
+  auto const start = std::chrono::steady_clock::now();
+  auto status = complete_status::COMPLETE;
+  if (confidence != nullptr) {
+    *confidence = 0.0F;
+  }
+
+  // true if the remaining stages have to be skipped
+  auto const interrupted = [&]() {
+    if (token != nullptr && token->cancelled()) {
+      status = complete_status::CANCELLED;
+    } else if (options.time_budget_.count() != 0 &&
+               std::chrono::steady_clock::now() - start >
+                   options.time_budget_) {
+      status = complete_status::DEGRADED;
+    }
+    return status != complete_status::COMPLETE;
+  };
+  auto const cancelled = [&]() {
+    return complete_result{std::vector<index_t>(), complete_status::CANCELLED};
+  };
+
+  if (token != nullptr && token->cancelled()) {
+    return cancelled();
+  } else if (tokens.empty()) {
+    return complete_result();
+  }
+
+  // temporaries are allocated from the arena of the scratch, the arena is
+  // grown for later queries if it was too small
+  struct scratch_lease {
+    ~scratch_lease() {
+      if (upstream_.overflow_ != 0) {
+        scratch_->arena_.resize(scratch_->arena_.size() +
+                                2 * upstream_.overflow_);
+      }
+      pool_.put_back(std::move(scratch_));
+    }
+    scratch_pool& pool_;
+    std::unique_ptr<query_scratch> scratch_;
+    overflow_counter upstream_;
+  };
+  auto lease = scratch_lease{*scratch_pool_, scratch_pool_->take(), {}};
+  auto& scratch = *lease.scratch_;
+  std::pmr::monotonic_buffer_resource mem(
+      scratch.arena_.data(), scratch.arena_.size(), &lease.upstream_);
+
+  // strings of different groups (split by separators) are not chained
+  auto postcodes = std::pmr::vector<index_t>(&mem);
+  auto clean_strings = std::pmr::vector<std::pmr::string>(&mem);
+  auto groups = std::pmr::vector<uint32_t>(&mem);
+  clean_strings.reserve(tokens.size());
+  groups.reserve(tokens.size());
+  auto group = uint32_t(0);
+  for (auto const& t : tokens) {
+    switch (t.type_) {
+      case token_type::WORD:
+        normalize(t.str_, clean_strings.emplace_back());
+        groups.emplace_back(group);
+        break;
+      case token_type::POSTCODE:
+        postcodes.emplace_back(t.postcode_);
+        break;
+      case token_type::SEPARATOR:
+        ++group;
+        break;
+      case token_type::HOUSE_NUMBER: break;
+    }
+  }
+
+  auto guess_strings = std::pmr::vector<std::pmr::string>(&mem);
+  guess_strings.reserve(2 * clean_strings.size());
   for (auto const& str : clean_strings) {
     if (str.length() >= 3) {
       guess_strings.emplace_back(str);
     }
   }
+  auto const num_unchained = guess_strings.size();
   if (options.string_chain_len_ > 1) {
     auto const start_i = options.first_string_is_place_ ? 1 : 0;
     for (size_t i = start_i; i + 1 < clean_strings.size(); ++i) {
       auto const chain_len =
           std::min(options.string_chain_len_,
                    static_cast<size_t>(clean_strings.size() - i));
-      auto str = clean_strings[i];
-      for (size_t j = 1; j != chain_len; ++j) {
-        str = str + " " + clean_strings[i + j];
+      auto str = std::pmr::string(clean_strings[i], &mem);
+      auto chained = false;
+      for (size_t j = 1; j != chain_len && groups[i + j] == groups[i]; ++j) {
+        chained = true;
+        str += ' ';
+        str += clean_strings[i + j];
       }
-      if (str.length() >= 3) {
-        guess_strings.emplace_back(str);
+      if (chained && str.length() >= 3) {
+        guess_strings.emplace_back(std::move(str));
       }
     }
   }
 
-  if (guess_strings.empty()) {
+  auto guesses = std::pmr::vector<ngram_match>(&mem);
+  if (guess_strings.empty() && postcodes.empty()) {
+    auto prefix = std::string();
+    for (auto const& str : clean_strings) {
+      if (!prefix.empty()) {
+        prefix += ' ';
+      }
+      prefix += str;
+    }
+    return complete_result{complete_prefix(prefix, options.max_results_),
+                           status};
+  } else if (guess_strings.empty()) {
     auto result = std::vector<index_t>();
     for (auto const& pc : postcodes) {
       auto const pc_it = postcode_to_index_.find(pc);
       if (pc_it != postcode_to_index_.end()) {
         for (auto const& pc_idx : pc_it->second) {
+          if (result.size() == options.max_results_) {
+            return complete_result{std::move(result), status};
+          }
           result.emplace_back(pc_idx);
         }
       }
     }
-    if (result.size() > options.max_results_) {
-      result.resize(options.max_results_);
+    return complete_result{std::move(result), status};
+  }
+
+  // the hot tier answers confident queries, the time it took counts
+  // against the budget of the full index
+  auto const tier = options.use_hot_tier_ ? std::atomic_load(&hot_tier_)
+                                          : std::shared_ptr<hot_tier const>();
+  if (tier != nullptr) {
+    auto hot_confidence = 0.0F;
+    auto hot = tier->typeahead_->complete_tokens(tokens, options, token,
+                                                 &hot_confidence);
+    if (hot.status_ == complete_status::CANCELLED) {
+      return cancelled();
+    }
+    if (hot.status_ == complete_status::COMPLETE &&
+        hot.ids_.size() >= options.max_results_ &&
+        hot_confidence >= tier->min_confidence_) {
+      ++tier_counters_->hot_hits_;
+      for (auto& id : hot.ids_) {
+        id = tier->ids_[id];
+      }
+      if (confidence != nullptr) {
+        *confidence = hot_confidence;
+      }
+      return hot;
+    }
+    ++tier_counters_->fallbacks_;
+  }
+
+  if (guess_strings.size() == 1 && postcodes.empty()) {
+    guess_match(place_guesser_, place_index_, guess_strings[0],
+                options.max_results_, guesses);
+    if (token != nullptr && token->cancelled()) {
+      return cancelled();
+    }
+    if (confidence != nullptr) {
+      for (auto const& g : guesses) {
+        *confidence = std::max(*confidence, g.cos_sim_);
+      }
     }
-    return result;
-  } else if (guess_strings.size() == 1 && postcodes.empty()) {
-    auto guesses =
-        place_guesser_.guess_match(guess_strings[0], options.max_results_);
     auto result = std::vector<index_t>();
     for (auto const& g : guesses) {
-      if (g.cos_sim >= options.min_sim_) {
-        for (auto const& p_idx : place_guess_to_index_[g.index]) {
+      if (g.cos_sim_ >= options.min_sim_) {
+        for (auto const& p_idx : place_guess_to_index_[g.index_]) {
+          if (result.size() == options.max_results_) {
+            return complete_result{std::move(result), status};
+          }
           result.emplace_back(p_idx);
         }
       }
     }
-    if (result.size() > options.max_results_) {
-      result.resize(options.max_results_);
-    }
-    return result;
+    return complete_result{std::move(result), status};
   }
 
   auto max_str_len = size_t(0);
-  auto string_weights = std::vector<float>();
+  auto string_weights = std::pmr::vector<float>(&mem);
+  string_weights.reserve(guess_strings.size());
   for (auto const& str : guess_strings) {
     max_str_len = std::max(max_str_len, str.length());
     string_weights.emplace_back(static_cast<float>(str.length()));
@@ -150,91 +766,298 @@ std::vector<index_t> typeahead::complete(
     string_weights[i] = std::max(0.6F, string_weights[i] * normalization_val);
   }
 
-  auto max_cos_sim_place = std::vector<float>(place_guess_to_index_.size());
-  auto max_cos_sim_area = std::vector<float>(area_guess_to_index_.size());
-  std::fill(max_cos_sim_place.begin(), max_cos_sim_place.end(), 0.0F);
-  std::fill(max_cos_sim_area.begin(), max_cos_sim_area.end(), 0.0F);
+  // best weighted similarity per matched name / area (sorted by index)
+  auto place_sims = std::pmr::vector<ngram_match>(&mem);
+  auto area_sims = std::pmr::vector<ngram_match>(&mem);
 
   if (options.first_string_is_place_) {
-    auto const& place_guesses =
-        place_guesser_.guess_match(guess_strings[0], options.max_guesses_);
-    for (auto const& pg : place_guesses) {
-      max_cos_sim_place[pg.index] =
-          std::max(max_cos_sim_place[pg.index], pg.cos_sim);
-    }
-
-    for (size_t i = 1; i != guess_strings.size(); ++i) {
-      auto const& area_guesses =
-          area_guesser_.guess_match(guess_strings[i], options.max_guesses_);
-      for (auto const& ag : area_guesses) {
-        max_cos_sim_area[ag.index] = std::max(max_cos_sim_area[ag.index],
-                                              ag.cos_sim * string_weights[i]);
+    guess_match(place_guesser_, place_index_, guess_strings[0],
+                options.max_guesses_, guesses);
+    place_sims.insert(end(place_sims), begin(guesses), end(guesses));
+
+    for (size_t i = 1; i != guess_strings.size() && !interrupted(); ++i) {
+      guess_match(area_guesser_, area_index_, guess_strings[i],
+                  options.max_guesses_, guesses);
+      for (auto const& ag : guesses) {
+        area_sims.emplace_back(ngram_match{area_of_guess(ag.index_),
+                                           ag.cos_sim_ * string_weights[i]});
       }
     }
   } else {
-    for (size_t i = 0; i != guess_strings.size(); ++i) {
-      auto const& place_guesses =
-          place_guesser_.guess_match(guess_strings[i], options.max_guesses_);
-      for (auto const& pg : place_guesses) {
-        max_cos_sim_place[pg.index] = std::max(max_cos_sim_place[pg.index],
-                                               pg.cos_sim * string_weights[i]);
+    for (size_t i = 0; i != guess_strings.size() && (i == 0 || !interrupted());
+         ++i) {
+      guess_match(place_guesser_, place_index_, guess_strings[i],
+                  options.max_guesses_, guesses);
+      for (auto const& pg : guesses) {
+        place_sims.emplace_back(
+            ngram_match{pg.index_, pg.cos_sim_ * string_weights[i]});
       }
 
-      auto const& area_guesses =
-          area_guesser_.guess_match(guess_strings[i], options.max_guesses_);
-      for (auto const& ag : area_guesses) {
-        max_cos_sim_area[ag.index] = std::max(max_cos_sim_area[ag.index],
-                                              ag.cos_sim * string_weights[i]);
+      guess_match(area_guesser_, area_index_, guess_strings[i],
+                  options.max_guesses_, guesses);
+      for (auto const& ag : guesses) {
+        area_sims.emplace_back(ngram_match{area_of_guess(ag.index_),
+                                           ag.cos_sim_ * string_weights[i]});
       }
     }
   }
+  // over budget: the guesses found so far are still scored
+  if (interrupted() && status == complete_status::CANCELLED) {
+    return cancelled();
+  }
 
-  for (size_t i = 0; i != acc_.size(); ++i) {
-    acc_[i] = {static_cast<index_t>(i), 0.0F};
+  // the maximum per index, matches below min_sim_ are dropped
+  auto const reduce = [&](std::pmr::vector<ngram_match>& sims) {
+    std::sort(begin(sims), end(sims),
+              [](ngram_match const& a, ngram_match const& b) {
+                return a.index_ < b.index_ ||
+                       (a.index_ == b.index_ && a.cos_sim_ > b.cos_sim_);
+              });
+    sims.erase(std::unique(begin(sims), end(sims),
+                           [](ngram_match const& a, ngram_match const& b) {
+                             return a.index_ == b.index_;
+                           }),
+               end(sims));
+    sims.erase(std::remove_if(begin(sims), end(sims),
+                              [&](ngram_match const& m) {
+                                return m.cos_sim_ < options.min_sim_;
+                              }),
+               end(sims));
+  };
+  reduce(place_sims);
+  reduce(area_sims);
+  for (auto& m : place_sims) {
+    m.cos_sim_ *= options.place_bias_;
   }
 
-  for (size_t i = 0; i != place_guess_to_index_.size(); ++i) {
-    if (max_cos_sim_place[i] >= options.min_sim_) {
-      for (auto const& place_idx : place_guess_to_index_[i]) {
-        acc_[place_idx].second = std::max(
-            acc_[place_idx].second, max_cos_sim_place[i] * options.place_bias_);
-      }
+  // First phase score of an entity: its best place similarity plus the
+  // similarities of its areas plus one per postcode hit. The posting lists
+  // (sources) are walked by descending bound: a place list bounds the score
+  // of its entities by its similarity plus the best area similarity per
+  // level plus all postcode hits, an area list (all place lists are walked
+  // before) by the best similarity per level of itself and the following
+  // area lists plus the postcode hits. The walk stops once the bound falls
+  // below the max_guesses_-th best score: no unseen entity can enter the
+  // top anymore.
+  auto const num_place_sources = place_sims.size();
+  auto const num_area_sources = area_sims.size();
+  auto const num_sources =
+      num_place_sources + num_area_sources + postcodes.size();
+  auto sources = std::pmr::vector<uint32_t>(&mem);
+  sources.resize(num_place_sources + num_area_sources);
+  std::iota(begin(sources), end(sources), 0U);
+  auto const source_sim = [&](uint32_t const s) {
+    return s < num_place_sources ? place_sims[s].cos_sim_
+                                 : area_sims[s - num_place_sources].cos_sim_;
+  };
+  auto const by_sim = [&](uint32_t const a, uint32_t const b) {
+    return source_sim(a) > source_sim(b) ||
+           (source_sim(a) == source_sim(b) && a < b);
+  };
+  std::sort(begin(sources), begin(sources) + num_place_sources, by_sim);
+  std::sort(begin(sources) + num_place_sources, end(sources), by_sim);
+
+  // rank_of[s]: position of source s in the walk
+  auto rank_of = std::pmr::vector<uint32_t>(num_sources, 0U, &mem);
+  for (auto r = size_t(0); r != sources.size(); ++r) {
+    rank_of[sources[r]] = static_cast<uint32_t>(r);
+  }
+  for (auto j = sources.size(); j != num_sources; ++j) {
+    rank_of[j] = static_cast<uint32_t>(j);
+    sources.emplace_back(static_cast<uint32_t>(j));
+  }
+
+  // similarity and rank by name / area id
+  constexpr auto const NO_RANK = std::numeric_limits<uint32_t>::max();
+  auto place_sim_of =
+      std::pmr::vector<float>(context_.names_.size(), 0.0F, &mem);
+  auto place_rank_of =
+      std::pmr::vector<uint32_t>(context_.names_.size(), NO_RANK, &mem);
+  for (auto i = size_t(0); i != num_place_sources; ++i) {
+    place_sim_of[place_sims[i].index_] = place_sims[i].cos_sim_;
+    place_rank_of[place_sims[i].index_] = rank_of[i];
+  }
+  auto area_sim_of =
+      std::pmr::vector<float>(context_.areas_.size(), 0.0F, &mem);
+  auto area_rank_of =
+      std::pmr::vector<uint32_t>(context_.areas_.size(), NO_RANK, &mem);
+  for (auto i = size_t(0); i != num_area_sources; ++i) {
+    area_sim_of[area_sims[i].index_] = area_sims[i].cos_sim_;
+    area_rank_of[area_sims[i].index_] = rank_of[num_place_sources + i];
+  }
+
+  // bound_of[r]: score bound of the entities first seen at rank r
+  auto const postcode_bound =
+      static_cast<float>(postcodes.size() * max_postcode_areas_);
+  auto bound_of = std::pmr::vector<float>(num_sources, postcode_bound, &mem);
+  auto level_sim = std::array<float, NUM_LEVEL_BITS>{};
+  auto area_bound = 0.0F;
+  for (auto r = num_place_sources + num_area_sources; r != num_place_sources;
+       --r) {
+    auto const& m = area_sims[sources[r - 1] - num_place_sources];
+    level_sim[level_bit(context_.areas_[m.index_].level_)] = m.cos_sim_;
+    area_bound = 0.0F;
+    for (auto l = size_t(0); l != NUM_LEVEL_BITS; ++l) {
+      area_bound += level_sim[l] * static_cast<float>(max_level_areas_[l]);
     }
+    bound_of[r - 1] += area_bound;
+  }
+  for (auto r = size_t(0); r != num_place_sources; ++r) {
+    bound_of[r] += source_sim(sources[r]) + area_bound;
   }
 
-  for (size_t i = 0; i != area_guess_to_index_.size(); ++i) {
-    if (max_cos_sim_area[i] >= options.min_sim_) {
-      for (auto const& area_idx : area_guess_to_index_[i]) {
-        acc_[area_idx].second += max_cos_sim_area[i];
+  // exact first phase score, first_rank: rank of the first source listing
+  // the entity (the additions are ordered like the original dense loops:
+  // place, areas ascending, postcodes)
+  auto const score_of = [&](index_t const id, uint32_t& first_rank) {
+    first_rank = NO_RANK;
+    auto score = 0.0F;
+    auto const add_name = [&](index_t const name_idx) {
+      if (place_rank_of[name_idx] != NO_RANK) {
+        score = std::max(score, place_sim_of[name_idx]);
+        first_rank = std::min(first_rank, place_rank_of[name_idx]);
+      }
+    };
+    add_name(context_.get_name_id(id));
+    for_each_alias(context_.aliases_, id,
+                   [&](alias const& a) { add_name(a.name_idx_); });
+
+    auto postcode_hits = 0U;
+    for (auto const area_id : areas_of(id)) {
+      auto const& a = context_.areas_[area_id];
+      if (a.level_ == POSTCODE) {
+        for (auto j = size_t(0); j != postcodes.size(); ++j) {
+          if (postcodes[j] == a.name_idx_) {
+            ++postcode_hits;
+            first_rank = std::min(
+                first_rank, static_cast<uint32_t>(num_place_sources +
+                                                  num_area_sources + j));
+          }
+        }
+      } else if (area_rank_of[area_id] != NO_RANK) {
+        score += area_sim_of[area_id];
+        first_rank = std::min(first_rank, area_rank_of[area_id]);
       }
     }
-  }
+    for (auto i = 0U; i != postcode_hits; ++i) {
+      score += 1.0F;
+    }
+    return score;
+  };
 
-  for (auto const& pc : postcodes) {
-    auto const pc_it = postcode_to_index_.find(pc);
-    if (pc_it != postcode_to_index_.end()) {
-      for (auto const& pc_idx : pc_it->second) {
-        acc_[pc_idx].second += 1.0F;
+  // top: max heap by better, the worst candidate first
+  using candidate = std::pair<float, index_t>;
+  auto const better = [&](candidate const& a, candidate const& b) {
+    return a.first > b.first ||
+           (a.first == b.first && more_important(a.second, b.second));
+  };
+  auto heap = std::pmr::vector<candidate>(&mem);
+  heap.reserve(std::min(options.max_guesses_, context_.importance_.size()));
+
+  auto const out_of_reach = [&](float const bound) {
+    return heap.size() == options.max_guesses_ &&
+           bound * BOUND_SLACK < heap.front().first;
+  };
+  auto const walk = [&](std::vector<index_t> const& list, uint32_t const rank) {
+    for (auto it = begin(list); it != end(list); ++it) {
+      // an entity is listed twice if an alias equals its name (adjacent)
+      auto const id = *it;
+      if (it != begin(list) && *(it - 1) == id) {
+        continue;
+      }
+      auto first_rank = uint32_t(0);
+      auto const score = score_of(id, first_rank);
+      if (first_rank != rank || score <= 0.0F) {
+        continue;
+      }
+      auto const c = candidate{score, id};
+      if (heap.size() < options.max_guesses_) {
+        heap.emplace_back(c);
+        std::push_heap(begin(heap), end(heap), better);
+      } else if (better(c, heap.front())) {
+        std::pop_heap(begin(heap), end(heap), better);
+        heap.back() = c;
+        std::push_heap(begin(heap), end(heap), better);
+      }
+      if (out_of_reach(bound_of[rank])) {
+        return false;
       }
     }
+    return true;
+  };
+
+  if (options.max_guesses_ != 0) {
+    for (auto r = uint32_t(0); r != num_sources; ++r) {
+      if (out_of_reach(bound_of[r])) {
+        break;
+      }
+      auto const s = sources[r];
+      auto complete_walk = true;
+      if (s < num_place_sources) {
+        complete_walk = walk(place_guess_to_index_[place_sims[s].index_], r);
+      } else if (s < num_place_sources + num_area_sources) {
+        complete_walk = walk(
+            area_guess_to_index_[area_sims[s - num_place_sources].index_], r);
+      } else {
+        auto const pc_it = postcode_to_index_.find(
+            postcodes[s - num_place_sources - num_area_sources]);
+        if (pc_it != postcode_to_index_.end()) {
+          complete_walk = walk(pc_it->second, r);
+        }
+      }
+      if (!complete_walk) {
+        break;
+      }
+    }
+  }
+
+  // the max_guesses_ best scored entities are reranked
+  std::sort(begin(heap), end(heap), better);
+  auto& top = scratch.top_;
+  top.clear();
+  for (auto const& [score, id] : heap) {
+    top.emplace_back(id);
   }
 
-  std::nth_element(
-      std::begin(acc_), std::begin(acc_) + options.max_guesses_, std::end(acc_),
-      [](auto const& lhs, auto const& rhs) { return lhs.second > rhs.second; });
+  // first phase results (without rerank) or nothing if cancelled
+  auto const stop = [&]() {
+    if (status == complete_status::CANCELLED) {
+      return cancelled();
+    }
+    auto const num_results = std::min(options.max_results_, top.size());
+    return complete_result{
+        std::vector<index_t>(begin(top), begin(top) + num_results), status};
+  };
+  if (interrupted()) {
+    return stop();
+  }
 
+  // the names of the top entities and their areas are matched again
+  // GUESS: by a guesser over them, NGRAM: by scoring them directly
   auto place_strings = std::vector<std::pair<std::string, float>>();
-  auto index_translation_table = std::vector<index_t>();
-  auto const i_max =
-      std::min(static_cast<size_t>(options.max_guesses_), acc_.size());
+  auto scorer = ngram_scorer(&mem);
+  auto const add_string = [&](std::string const& str, float const weight) {
+    if (engine_ == match_engine::NGRAM) {
+      scorer.add(str, weight);
+    } else {
+      place_strings.emplace_back(str, weight);
+    }
+  };
+
+  auto index_translation_table = std::pmr::vector<index_t>(&mem);
+  auto const i_max = top.size();
+  auto top_scores = std::pmr::vector<float>(i_max, 0.0F, &mem);
   for (size_t i = 0; i != i_max; ++i) {
-    place_strings.emplace_back(context_.get_name(acc_[i].first),
-                               options.place_bias_);
+    add_string(context_.name_keys_[context_.get_name_id(top[i])],
+               options.place_bias_);
     index_translation_table.emplace_back(static_cast<index_t>(i));
+    for_each_alias(context_.aliases_, top[i], [&](alias const& a) {
+      add_string(context_.name_keys_[a.name_idx_], options.place_bias_);
+      index_translation_table.emplace_back(static_cast<index_t>(i));
+    });
 
     auto num_of_postcode_matches = 0;
-    auto const area_ids = context_.get_area_ids(acc_[i].first);
-    for (auto const& area_id : area_ids) {
+    for (auto const& area_id : areas_of(top[i])) {
       auto const& a = context_.areas_[area_id];
       if (a.level_ == POSTCODE) {
         for (auto const& pc : postcodes) {
@@ -244,45 +1067,76 @@ std::vector<index_t> typeahead::complete(
         }
         continue;
       }
-      place_strings.emplace_back(context_.area_names_[a.name_idx_],
-                                 a.popularity_);
+      add_string(context_.area_name_keys_[a.name_idx_], a.popularity_);
       index_translation_table.emplace_back(static_cast<index_t>(i));
+      for_each_alias(context_.area_aliases_, area_id, [&](alias const& al) {
+        add_string(context_.area_name_keys_[al.name_idx_], a.popularity_);
+        index_translation_table.emplace_back(static_cast<index_t>(i));
+      });
     }
 
     if (!postcodes.empty()) {
-      acc_[i].second = static_cast<float>(num_of_postcode_matches) /
-                       static_cast<float>(postcodes.size());
-    } else {
-      acc_[i].second = 0.0F;
+      top_scores[i] = static_cast<float>(num_of_postcode_matches) /
+                      static_cast<float>(postcodes.size());
     }
   }
 
-  auto max_value = std::vector<float>(i_max);
-  auto new_guesser = guess::guesser(place_strings);
+  auto new_guesser = std::optional<guess::guesser>();
+  if (engine_ == match_engine::GUESS) {
+    new_guesser.emplace(place_strings);
+  }
+  if (interrupted()) {
+    return stop();
+  }
+
+  auto const& kernels = get_score_kernels();
+  auto max_value = std::pmr::vector<float>(i_max, 0.0F, &mem);
   for (size_t str_i = 0; str_i != guess_strings.size(); ++str_i) {
     auto const& str = guess_strings[str_i];
-    auto const guesses = new_guesser.guess_match(str, options.max_guesses_);
+    if (engine_ == match_engine::NGRAM) {
+      scorer.match(str, options.max_guesses_, guesses);
+    } else {
+      guess_match(*new_guesser, ngram_index(), str, options.max_guesses_,
+                  guesses);
+    }
     std::fill(max_value.begin(), max_value.end(), 0.0F);
     for (auto const& g : guesses) {
-      max_value[index_translation_table[g.index]] =
-          std::max(max_value[index_translation_table[g.index]], g.cos_sim);
-    }
-    for (size_t i = 0; i != i_max; ++i) {
-      acc_[i].second += max_value[i] * string_weights[str_i];
+      max_value[index_translation_table[g.index_]] =
+          std::max(max_value[index_translation_table[g.index_]], g.cos_sim_);
     }
+    kernels.multiply_add_(top_scores.data(), max_value.data(), i_max,
+                          string_weights[str_i]);
   }
 
-  std::sort(
-      acc_.begin(), acc_.begin() + options.max_guesses_,
-      [](auto const& lhs, auto const& rhs) { return lhs.second > rhs.second; });
+  auto& selected = scratch.selected_;
+  selected.clear();
+  kernels.select_geq_(top_scores.data(), i_max, options.min_sim_, selected);
+  auto const num_results = std::min(options.max_results_, selected.size());
+  std::partial_sort(begin(selected), begin(selected) + num_results,
+                    end(selected), [&](uint32_t const lhs, uint32_t const rhs) {
+                      return top_scores[lhs] > top_scores[rhs] ||
+                             (top_scores[lhs] == top_scores[rhs] &&
+                              more_important(top[lhs], top[rhs]));
+                    });
 
-  auto result = std::vector<index_t>();
-  for (size_t i = 0; i != options.max_results_; ++i) {
-    if (acc_[i].second >= options.min_sim_) {
-      result.emplace_back(acc_[i].first);
+  // the best score relative to a full match of every string (chained ones
+  // only if there are no others) and postcode, clamped to 1
+  if (confidence != nullptr && num_results != 0) {
+    auto full_match = postcodes.empty() ? 0.0F : 1.0F;
+    auto const num_strings =
+        num_unchained == 0 ? guess_strings.size() : num_unchained;
+    for (size_t i = 0; i != num_strings; ++i) {
+      full_match += string_weights[i];
     }
+    *confidence = std::min(1.0F, top_scores[selected[0]] / full_match);
   }
-  return result;
+
+  auto result = std::vector<index_t>();
+  result.reserve(num_results);
+  for (size_t i = 0; i != num_results; ++i) {
+    result.emplace_back(top[selected[i]]);
+  }
+  return complete_result{std::move(result), status};
 }
 
 }  // namespace address_typeahead
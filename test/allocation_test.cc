@@ -0,0 +1,56 @@
+#include <atomic>
+#include <cstdlib>
+#include <fstream>
+#include <new>
+
+#include <gtest/gtest.h>
+
+#include <cereal/archives/binary.hpp>
+
+#include "address-typeahead/serialization.h"
+#include "address-typeahead/typeahead.h"
+
+using namespace address_typeahead;
+
+namespace {
+
+std::atomic<size_t> allocations{0};
+
+}  // namespace
+
+void* operator new(size_t const size) {
+  ++allocations;
+  if (auto const p = std::malloc(size == 0 ? 1 : size); p != nullptr) {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+
+TEST(Test, test_steady_state_query_allocations) {
+  auto context = typeahead_context();
+  {
+    std::ifstream in("../test_resources/out.map", std::ios::binary);
+    cereal::BinaryInputArchive ia(in);
+    ia(context);
+  }
+  auto const t = typeahead(context, match_engine::NGRAM);
+  auto const strings = std::vector<std::string>{"gartenstr", "bremerhaven"};
+  auto const options = complete_options();
+
+  // the first queries grow the arena of the query scratch
+  auto const expected = t.complete(strings, options, nullptr);
+  t.complete(strings, options, nullptr);
+
+  auto const before = allocations.load();
+  auto const result = t.complete(strings, options, nullptr);
+  auto const after = allocations.load();
+
+  ASSERT_FALSE(result.ids_.empty());
+  EXPECT_EQ(expected.ids_, result.ids_);
+
+  // only the returned ids
+  EXPECT_EQ(1U, after - before);
+}
@@ -0,0 +1,146 @@
+#include <cstdio>
+#include <fstream>
+
+#include <gtest/gtest.h>
+
+#include "address-typeahead/area_cache.h"
+#include "address-typeahead/extractor.h"
+
+using namespace address_typeahead;
+
+prepared_polygon make_triangle(int32_t const x, int32_t const y) {
+  polygon pol;
+  bg::append(pol.outer(), point(x, y));
+  bg::append(pol.outer(), point(x, y + 100000));
+  bg::append(pol.outer(), point(x + 100000, y));
+  bg::append(pol.outer(), point(x, y));
+
+  multi_polygon mp;
+  mp.push_back(pol);
+  return prepared_polygon(mp);
+}
+
+TEST(Test, test_area_cache_round_trip) {
+  auto const path = std::string("test_area_cache.bin");
+
+  area_cache cache;
+  cache.key_.input_path_ = "/data/bremen.osm.pbf";
+  cache.key_.input_size_ = 1234;
+  cache.areas_ = {area{0, ADMIN_LEVEL_4, 1.5F}, area{28195, POSTCODE, 1.0F}};
+  cache.area_names_ = {"Bremen"};
+  cache.area_osm_ids_ = {3, 5};
+  cache.area_population_ = {42, 0};
+  cache.polygons_ = {make_triangle(0, 0), make_triangle(50000, 0)};
+  cache.lookup_ = area_lookup(cache.polygons_, area_lookup_options());
+  write_area_cache(path, cache);
+
+  area_cache read;
+  ASSERT_TRUE(read_area_cache(path, cache.key_, read));
+  EXPECT_EQ(cache.area_names_, read.area_names_);
+  EXPECT_EQ(cache.area_osm_ids_, read.area_osm_ids_);
+  EXPECT_EQ(cache.area_population_, read.area_population_);
+  ASSERT_EQ(2U, read.areas_.size());
+  EXPECT_EQ(28195U, read.areas_[1].name_idx_);
+  ASSERT_EQ(2U, read.polygons_.size());
+  EXPECT_EQ(cache.polygons_[1].strip_edges_, read.polygons_[1].strip_edges_);
+  EXPECT_EQ(cache.lookup_.cells_.size(), read.lookup_.cells_.size());
+
+  for (auto const x : {1000, 40000, 60000, 140000}) {
+    auto expected = std::vector<index_t>();
+    auto actual = std::vector<index_t>();
+    cache.lookup_.lookup(point(x, 1000), cache.polygons_, expected);
+    read.lookup_.lookup(point(x, 1000), read.polygons_, actual);
+    EXPECT_EQ(expected, actual);
+  }
+
+  // another input or other options invalidate the cache
+  auto other_key = cache.key_;
+  other_key.simplify_tolerance_ = 10;
+  EXPECT_FALSE(read_area_cache(path, other_key, read));
+  EXPECT_FALSE(read_area_cache("missing_area_cache.bin", cache.key_, read));
+
+  std::remove(path.c_str());
+}
+
+TEST(Test, test_area_cache_invalid_indices) {
+  auto const path = std::string("test_area_cache_invalid.bin");
+
+  area_cache cache;
+  cache.areas_ = {area{0, ADMIN_LEVEL_4, 1.0F}};
+  cache.area_names_ = {"Bremen"};
+  cache.polygons_ = {make_triangle(0, 0)};
+  cache.lookup_ = area_lookup(cache.polygons_, area_lookup_options());
+
+  auto const readable = [&](area_cache const& c) {
+    write_area_cache(path, c);
+    area_cache read;
+    auto const success = read_area_cache(path, c.key_, read);
+    EXPECT_EQ(success, !read.areas_.empty());
+    return success;
+  };
+  EXPECT_TRUE(readable(cache));
+
+  auto unknown_area = cache;
+  unknown_area.lookup_.set_areas_.back() = 1;
+  EXPECT_FALSE(readable(unknown_area));
+
+  auto unknown_set = cache;
+  unknown_set.lookup_.cells_.back().boundary_set_ =
+      static_cast<uint32_t>(cache.lookup_.set_offsets_.size());
+  EXPECT_FALSE(readable(unknown_set));
+
+  auto child_cycle = cache;
+  child_cycle.lookup_.cells_.assign(5, area_lookup::cell{0, 0, 0});
+  child_cycle.lookup_.cells_[0].first_child_ = 1;
+  EXPECT_TRUE(readable(child_cycle));
+  child_cycle.lookup_.cells_[1].first_child_ = 1;
+  EXPECT_FALSE(readable(child_cycle));
+
+  auto missing_polygon = cache;
+  missing_polygon.polygons_.push_back(make_triangle(50000, 0));
+  EXPECT_FALSE(readable(missing_polygon));
+
+  auto unknown_vertex = cache;
+  unknown_vertex.polygons_[0].strip_edges_.back() =
+      static_cast<uint32_t>(cache.polygons_[0].vertices_.size());
+  EXPECT_FALSE(readable(unknown_vertex));
+
+  std::remove(path.c_str());
+}
+
+TEST(Test, test_extract_without_area_cache) {
+  auto const path = std::string("test_no_area_cache.osm");
+  {
+    std::ofstream out(path);
+    out << "<?xml version='1.0' encoding='UTF-8'?>\n"
+        << "<osm version=\"0.6\" generator=\"test\">\n"
+        << "<node id=\"1\" version=\"1\" lat=\"0.0\" lon=\"0.0\"/>\n"
+        << "<node id=\"2\" version=\"1\" lat=\"0.0\" lon=\"1.0\"/>\n"
+        << "<node id=\"3\" version=\"1\" lat=\"1.0\" lon=\"1.0\"/>\n"
+        << "<node id=\"4\" version=\"1\" lat=\"1.0\" lon=\"0.0\"/>\n"
+        << "<node id=\"5\" version=\"1\" lat=\"0.5\" lon=\"0.5\">"
+        << "<tag k=\"name\" v=\"Marktplatz\"/>"
+        << "<tag k=\"place\" v=\"square\"/></node>\n"
+        << "<way id=\"10\" version=\"1\">"
+        << "<nd ref=\"1\"/><nd ref=\"2\"/><nd ref=\"3\"/><nd ref=\"4\"/>"
+        << "<nd ref=\"1\"/>"
+        << "<tag k=\"boundary\" v=\"administrative\"/>"
+        << "<tag k=\"admin_level\" v=\"8\"/>"
+        << "<tag k=\"name\" v=\"Stadt\"/></way>\n"
+        << "</osm>\n";
+  }
+
+  // without a cache path the input is never inspected for a cache key
+  auto options = extract_options();
+  options.whitelist_add("place");
+  ASSERT_TRUE(options.area_cache_path_.empty());
+  auto report = extract_report();
+  auto const context = extract(path, options, report);
+  std::remove(path.c_str());
+
+  EXPECT_FALSE(report.area_cache_hit_);
+  ASSERT_EQ(1U, context.areas_.size());
+  ASSERT_EQ(1U, context.places_.size());
+  EXPECT_EQ("Marktplatz", context.get_name(0));
+  EXPECT_EQ((std::vector<index_t>{0}), context.places_[0].areas_);
+}
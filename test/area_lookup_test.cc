@@ -0,0 +1,110 @@
+#include <gtest/gtest.h>
+
+#include "address-typeahead/area_lookup.h"
+
+using namespace address_typeahead;
+
+prepared_polygon make_square(int32_t const min_x, int32_t const min_y,
+                             int32_t const size) {
+  polygon pol;
+  bg::append(pol.outer(), point(min_x, min_y));
+  bg::append(pol.outer(), point(min_x, min_y + size));
+  bg::append(pol.outer(), point(min_x + size, min_y + size));
+  bg::append(pol.outer(), point(min_x + size, min_y));
+  bg::append(pol.outer(), point(min_x, min_y));
+
+  multi_polygon mp;
+  mp.push_back(pol);
+  return prepared_polygon(mp);
+}
+
+std::vector<index_t> lookup(area_lookup const& l,
+                            std::vector<prepared_polygon> const& polygons,
+                            int32_t const x, int32_t const y) {
+  auto result = std::vector<index_t>();
+  l.lookup(point(x, y), polygons, result);
+  return result;
+}
+
+TEST(Test, test_area_lookup_exact) {
+  auto const polygons = std::vector<prepared_polygon>{
+      make_square(0, 0, 1000000), make_square(500000, 500000, 1000000),
+      prepared_polygon()};
+
+  auto options = area_lookup_options();
+  options.min_cell_size_ = 1000;
+  options.max_leaf_edges_ = 0;
+  auto const l = area_lookup(polygons, options);
+
+  EXPECT_EQ(std::vector<index_t>({0}), lookup(l, polygons, 100, 100));
+  EXPECT_EQ(std::vector<index_t>({0, 1}),
+            lookup(l, polygons, 600000, 600000));
+  EXPECT_EQ(std::vector<index_t>({1}),
+            lookup(l, polygons, 1400000, 1400000));
+  EXPECT_EQ(std::vector<index_t>(), lookup(l, polygons, 1400000, 100));
+  EXPECT_EQ(std::vector<index_t>(), lookup(l, polygons, -5, 100));
+  EXPECT_EQ(std::vector<index_t>({0}), lookup(l, polygons, 499999, 999999));
+  EXPECT_EQ(std::vector<index_t>({1}), lookup(l, polygons, 1000001, 500001));
+}
+
+TEST(Test, test_area_lookup_approximate) {
+  auto const polygons = std::vector<prepared_polygon>{
+      make_square(0, 0, 1000000), make_square(500000, 500000, 1000000)};
+
+  auto options = area_lookup_options();
+  options.min_cell_size_ = 100000;
+  options.exact_ = false;
+  auto const l = area_lookup(polygons, options);
+
+  EXPECT_EQ(std::vector<index_t>({0}), lookup(l, {}, 200000, 200000));
+  EXPECT_EQ(std::vector<index_t>({0, 1}), lookup(l, {}, 750000, 750000));
+  EXPECT_EQ(std::vector<index_t>({1}), lookup(l, {}, 1250000, 1250000));
+}
+
+TEST(Test, test_area_lookup_without_areas) {
+  auto const polygons = std::vector<prepared_polygon>{prepared_polygon()};
+  auto const l = area_lookup(polygons, area_lookup_options());
+  EXPECT_TRUE(l.cells_.empty());
+  EXPECT_EQ(2U, l.set_offsets_.size());
+  EXPECT_TRUE(lookup(l, polygons, 0, 0).empty());
+  EXPECT_TRUE(lookup(area_lookup(), polygons, 0, 0).empty());
+}
+
+TEST(Test, test_area_lookup_approximate_builder) {
+  auto const polygons = std::vector<prepared_polygon>{
+      make_square(0, 0, 1000000), prepared_polygon(),
+      make_square(500000, 500000, 1000000), make_square(-300000, 1200000, 7)};
+
+  auto options = area_lookup_options();
+  options.min_cell_size_ = 10000;
+  options.exact_ = false;
+  auto const expected = area_lookup(polygons, options);
+
+  auto bounds = box();
+  bg::assign_inverse(bounds);
+  for (auto const& pol : polygons) {
+    if (!pol.strip_edges_.empty()) {
+      bg::expand(bounds, pol.envelope_);
+    }
+  }
+  auto builder = area_lookup::approximate_builder(bounds, options);
+  for (auto i = polygons.size(); i != 0; --i) {
+    builder.add(static_cast<index_t>(i - 1), polygons[i - 1]);
+  }
+  auto const l = builder.finish();
+
+  EXPECT_TRUE(bg::equals(expected.bounds_, l.bounds_));
+  ASSERT_EQ(expected.cells_.size(), l.cells_.size());
+  for (auto i = size_t(0); i != l.cells_.size(); ++i) {
+    EXPECT_EQ(expected.cells_[i].first_child_, l.cells_[i].first_child_);
+    EXPECT_EQ(expected.cells_[i].inside_set_, l.cells_[i].inside_set_);
+    EXPECT_EQ(expected.cells_[i].boundary_set_, l.cells_[i].boundary_set_);
+  }
+  EXPECT_EQ(expected.set_offsets_, l.set_offsets_);
+  EXPECT_EQ(expected.set_areas_, l.set_areas_);
+  EXPECT_EQ(std::vector<index_t>({0, 2}), lookup(l, {}, 750000, 750000));
+
+  auto const empty = area_lookup::approximate_builder(bounds, options).finish();
+  EXPECT_TRUE(empty.cells_.empty());
+  EXPECT_EQ(std::vector<uint32_t>({0, 0}), empty.set_offsets_);
+}
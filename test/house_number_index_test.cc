@@ -0,0 +1,89 @@
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "address-typeahead/house_number_index.h"
+
+using namespace address_typeahead;
+
+TEST(Test, test_natural_less) {
+  auto numbers = std::vector<std::string>{"10", "2a", "a", "2", "010b",
+                                          "1",  "9",  "2b", "100"};
+  std::sort(begin(numbers), end(numbers), natural_less);
+  EXPECT_EQ((std::vector<std::string>{"1", "2", "2a", "2b", "9", "10",
+                                      "010b", "100", "a"}),
+            numbers);
+}
+
+TEST(Test, test_house_number_index) {
+  typeahead_context context;
+  context.house_numbers_ = {"", "1", "10", "11 A", "2", "12", "1a", "3"};
+  auto& s = context.streets_.emplace_back();
+  for (auto const hn_idx : {2, 1, 3, 4, 5, 6, 7, 1}) {
+    s.house_numbers_.emplace_back(house_number{
+        static_cast<index_t>(hn_idx), coordinates{hn_idx, hn_idx}});
+  }
+  context.streets_.emplace_back();
+  auto const index = house_number_index(context);
+
+  auto const match = [&](std::string const& prefix, size_t const count) {
+    auto result = std::vector<std::string>();
+    for (auto const& hn : index.match(context, 0, prefix, count)) {
+      EXPECT_EQ(context.house_numbers_[hn.coordinates_.lat_], hn.house_number_);
+      EXPECT_FALSE(hn.interpolated_);
+      result.emplace_back(hn.house_number_);
+    }
+    return result;
+  };
+
+  EXPECT_EQ((std::vector<std::string>{"1", "1a", "10", "11 A", "12"}),
+            match("1", 10));
+  EXPECT_EQ((std::vector<std::string>{"1", "1a", "10"}), match("1", 3));
+  EXPECT_EQ((std::vector<std::string>{"11 A"}), match("11a", 10));
+  EXPECT_EQ((std::vector<std::string>{"1", "1a", "2", "3", "10", "11 A",
+                                      "12"}),
+            match("", 10));
+  EXPECT_TRUE(match("4", 10).empty());
+  EXPECT_TRUE(index.match(context, 1, "", 10).empty());
+}
+
+TEST(Test, test_house_number_index_interpolation) {
+  typeahead_context context;
+  context.house_numbers_ = {"", "1", "9", "3a"};
+  context.places_ = {location{0, coordinates{0, 0}, {}}};
+  context.streets_ = {street{0,
+                             {house_number{1, {0, 0}},
+                              house_number{2, {40, 40}},
+                              house_number{3, {10, 10}}},
+                             {}}};
+  context.interpolations_ = {
+      interpolation{1, 1, 9, 2, {{0, 0}, {0, 40}, {40, 40}}},
+      interpolation{1, 11, 13, 2, {{40, 40}, {40, 60}}},
+      interpolation{1, 5, 5, 0, {{0, 0}, {0, 40}}}};
+  auto const index = house_number_index(context);
+
+  auto const match = [&](std::string const& prefix, size_t const count) {
+    auto result = std::vector<std::string>();
+    for (auto const& hn : index.match(context, 0, prefix, count)) {
+      result.emplace_back(hn.house_number_ + (hn.interpolated_ ? "*" : ""));
+    }
+    return result;
+  };
+
+  EXPECT_EQ((std::vector<std::string>{"1", "3*", "3a", "5*", "7*", "9", "11*",
+                                      "13*"}),
+            match("", 20));
+  EXPECT_EQ((std::vector<std::string>{"1", "11*", "13*"}), match("1", 20));
+  EXPECT_EQ((std::vector<std::string>{"1", "3*"}), match("", 2));
+
+  auto const seven = index.match(context, 0, "7", 1);
+  ASSERT_EQ(1U, seven.size());
+  EXPECT_EQ(20, seven[0].coordinates_.lon_);
+  EXPECT_EQ(40, seven[0].coordinates_.lat_);
+
+  EXPECT_EQ((std::vector<std::string>{"1", "9", "3a", "3", "5", "7", "11",
+                                      "13"}),
+            context.get_house_numbers(1));
+}
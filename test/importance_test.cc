@@ -0,0 +1,28 @@
+#include <gtest/gtest.h>
+
+#include "address-typeahead/importance.h"
+
+using namespace address_typeahead;
+
+TEST(Test, test_importance) {
+  typeahead_context context;
+  context.areas_ = {area{0, ADMIN_LEVEL_8, 1.5F}, area{1, ADMIN_LEVEL_8, 1.1F},
+                    area{2, POSTCODE, 1.0F}};
+  context.places_ = {location{0, coordinates{0, 0}, {0, 2}},
+                     location{1, coordinates{0, 0}, {1, 2}},
+                     location{2, coordinates{0, 0}, {}}};
+  context.streets_ = {
+      street{3, {house_number{0, coordinates{0, 0}}}, {1}},
+      street{3, std::vector<house_number>(4000), {1}}};
+  add_importance(context, 2);
+
+  ASSERT_EQ(5U, context.importance_.size());
+  EXPECT_FLOAT_EQ(1.25F, context.importance_[0]);
+  EXPECT_FLOAT_EQ(1.05F, context.importance_[1]);
+  EXPECT_FLOAT_EQ(1.0F, context.importance_[2]);
+
+  // streets with more house numbers are more important, the bonus is capped
+  EXPECT_GT(context.importance_[3], context.importance_[1]);
+  EXPECT_GT(context.importance_[4], context.importance_[3]);
+  EXPECT_FLOAT_EQ(1.25F, context.importance_[4]);
+}
@@ -0,0 +1,43 @@
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "address-typeahead/interner.h"
+
+using namespace address_typeahead;
+
+TEST(Test, test_string_interner) {
+  string_interner strings;
+  EXPECT_EQ(0U, strings.intern(""));
+  EXPECT_EQ(1U, strings.intern("Gartenstraße"));
+  EXPECT_EQ(2U, strings.intern("Hauptstraße"));
+  EXPECT_EQ(1U, strings.intern(std::string("Garten") + "straße"));
+  EXPECT_EQ(3U, strings.size());
+
+  // strings larger than an arena block and many small ones stay valid
+  auto const large = std::string(3U << 20U, 'x');
+  EXPECT_EQ(3U, strings.intern(large));
+  for (auto i = 0; i != 100000; ++i) {
+    strings.intern(std::to_string(i));
+  }
+  EXPECT_EQ("", strings.get(0));
+  EXPECT_EQ("Gartenstraße", strings.get(1));
+  EXPECT_EQ(large, strings.get(3));
+  EXPECT_EQ("99999", strings.get(strings.intern("99999")));
+}
+
+TEST(Test, test_index_set_interner) {
+  index_set_interner sets;
+  auto const a = std::vector<index_t>{1, 5, 7};
+  auto const b = std::vector<index_t>{1, 5};
+
+  EXPECT_EQ(0U, sets.intern(nullptr, nullptr));
+  EXPECT_EQ(1U, sets.intern(a.data(), a.data() + a.size()));
+  EXPECT_EQ(2U, sets.intern(b.data(), b.data() + b.size()));
+  EXPECT_EQ(1U, sets.intern(a.data(), a.data() + a.size()));
+  EXPECT_EQ(3U, sets.size());
+
+  EXPECT_TRUE(sets.get(0).empty());
+  EXPECT_EQ(a, sets.get(1));
+  EXPECT_EQ(b, sets.get(2));
+}
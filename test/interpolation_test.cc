@@ -0,0 +1,104 @@
+#include <gtest/gtest.h>
+
+#include "address-typeahead/interpolation.h"
+#include "address-typeahead/merge.h"
+#include "address-typeahead/reverse_geocoder.h"
+
+using namespace address_typeahead;
+
+TEST(Test, test_interpolate) {
+  auto number = uint32_t(0);
+  EXPECT_TRUE(parse_house_number("42", number));
+  EXPECT_EQ(42U, number);
+  EXPECT_FALSE(parse_house_number("42a", number));
+  EXPECT_FALSE(parse_house_number("", number));
+
+  auto step = uint32_t(0);
+  EXPECT_TRUE(parse_interpolation_step("even", step));
+  EXPECT_EQ(2U, step);
+  EXPECT_TRUE(parse_interpolation_step("all", step));
+  EXPECT_EQ(1U, step);
+  EXPECT_TRUE(parse_interpolation_step("3", step));
+  EXPECT_EQ(3U, step);
+  EXPECT_FALSE(parse_interpolation_step("alphabetic", step));
+  EXPECT_FALSE(parse_interpolation_step("0", step));
+
+  // 1, 3, ..., 9 along an L-shaped line of length 80
+  auto const i = interpolation{0, 1, 9, 2, {{0, 0}, {0, 40}, {40, 40}}};
+  auto c = coordinates();
+  ASSERT_TRUE(interpolate(i, 5, c));
+  EXPECT_EQ(0, c.lon_);
+  EXPECT_EQ(40, c.lat_);
+  ASSERT_TRUE(interpolate(i, 7, c));
+  EXPECT_EQ(20, c.lon_);
+  EXPECT_EQ(40, c.lat_);
+  ASSERT_TRUE(interpolate(i, 9, c));
+  EXPECT_EQ(40, c.lon_);
+  EXPECT_FALSE(interpolate(i, 4, c));
+  EXPECT_FALSE(interpolate(i, 11, c));
+
+  // a range without a step contains no numbers
+  auto const no_step = interpolation{0, 1, 9, 0, {{0, 0}, {0, 40}}};
+  EXPECT_FALSE(interpolate(no_step, 1, c));
+  EXPECT_FALSE(interpolate(no_step, 5, c));
+}
+
+typeahead_context make_interpolation_context() {
+  typeahead_context c;
+  c.names_ = {"Testcenter", "Gartenstraße"};
+  c.house_numbers_ = {"", "1", "9"};
+  c.areas_ = {area{0, ADMIN_LEVEL_8, 1.0F}};
+  c.area_names_ = {"Bremerhaven"};
+  c.places_ = {location{0, coordinates{0, 0}, {0}}};
+  c.streets_ = {street{
+      1, {house_number{1, {0, 0}}, house_number{2, {40, 40}}}, {0}}};
+  c.interpolations_ = {
+      interpolation{1, 1, 9, 2, {{0, 0}, {0, 40}, {40, 40}}}};
+  return c;
+}
+
+TEST(Test, test_coordinates_for_interpolated_house_number) {
+  auto const check = [](typeahead_context const& c, index_t const id) {
+    auto lat = 0.0;
+    auto lon = 0.0;
+    ASSERT_TRUE(c.coordinates_for_house_number(id, "9", lat, lon));
+    EXPECT_DOUBLE_EQ(40 / 10000000.0, lon);
+    ASSERT_TRUE(c.coordinates_for_house_number(id, "7", lat, lon));
+    EXPECT_DOUBLE_EQ(20 / 10000000.0, lon);
+    EXPECT_DOUBLE_EQ(40 / 10000000.0, lat);
+    EXPECT_FALSE(c.coordinates_for_house_number(id, "6", lat, lon));
+    EXPECT_FALSE(c.coordinates_for_house_number(id, "7a", lat, lon));
+    EXPECT_FALSE(c.coordinates_for_house_number(0, "7", lat, lon));
+  };
+  auto const c = make_interpolation_context();
+  check(c, 1);
+
+  // ranges contained in both inputs are kept once
+  auto const merged =
+      merge({make_interpolation_context(), make_interpolation_context()});
+  ASSERT_EQ(1U, merged.interpolations_.size());
+  EXPECT_EQ(1U, merged.interpolations_[0].id_);
+  check(merged, 1);
+}
+
+TEST(Test, test_reverse_geocoding_interpolated_house_number) {
+  auto const c = make_interpolation_context();
+  auto const geocoder = reverse_geocoder(c);
+
+  // 7 is interpolated at (20, 40)
+  auto const result = geocoder.lookup(40 / 10000000.0, 20 / 10000000.0);
+  ASSERT_EQ(1U, result.size());
+  EXPECT_EQ(1U, result[0].id_);
+  EXPECT_EQ(NO_HOUSE_NUMBER, result[0].house_number_);
+  EXPECT_TRUE(result[0].interpolated_);
+  EXPECT_EQ(7U, result[0].interpolated_number_);
+  EXPECT_LT(result[0].distance_, 0.1);
+
+  // 9 is mapped at (40, 40): not interpolated again
+  auto const mapped = geocoder.lookup(40 / 10000000.0, 40 / 10000000.0, 2);
+  ASSERT_EQ(2U, mapped.size());
+  EXPECT_EQ(1U, mapped[0].id_);
+  EXPECT_EQ(1U, mapped[0].house_number_);
+  EXPECT_FALSE(mapped[0].interpolated_);
+  EXPECT_EQ(7U, mapped[1].interpolated_number_);
+}
@@ -0,0 +1,31 @@
+#include <gtest/gtest.h>
+
+#include "address-typeahead/labels.h"
+
+using namespace address_typeahead;
+
+TEST(Test, test_labels) {
+  typeahead_context context;
+  context.names_ = {"Testcenter", "Gartenstraße", "Nowhere"};
+  context.area_names_ = {"Mitte-Nord", "Bremerhaven"};
+  context.areas_ = {area{0, ADMIN_LEVEL_9, 1.0F},
+                    area{1, ADMIN_LEVEL_8, 1.0F}, area{27568, POSTCODE, 1.0F}};
+  context.places_ = {location{0, coordinates{0, 0}, {1, 0, 2}},
+                     location{2, coordinates{0, 0}, {}}};
+  context.streets_ = {street{1, {}, {0, 1, 2}}};
+
+  auto const expected = std::vector<std::string>{
+      "Testcenter, 27568, Mitte-Nord, Bremerhaven", "Nowhere",
+      "Gartenstraße, 27568, Mitte-Nord, Bremerhaven"};
+  for (auto i = index_t(0); i != 3; ++i) {
+    EXPECT_EQ(expected[i], context.get_label(i));
+  }
+
+  add_labels(context, 2);
+  ASSERT_EQ(3U, context.label_areas_.size());
+  EXPECT_EQ(2U, context.area_labels_.size());
+  EXPECT_EQ(context.label_areas_[0], context.label_areas_[2]);
+  for (auto i = index_t(0); i != 3; ++i) {
+    EXPECT_EQ(expected[i], context.get_label(i));
+  }
+}
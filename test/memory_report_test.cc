@@ -0,0 +1,41 @@
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "address-typeahead/memory_report.h"
+
+using namespace address_typeahead;
+
+TEST(Test, test_heap_bytes) {
+  auto ids = std::vector<uint32_t>();
+  ids.reserve(10);
+  EXPECT_EQ(40U, heap_bytes(ids));
+
+  auto const long_string = std::string(100, 'x');
+  EXPECT_EQ(long_string.capacity() + 1, heap_bytes(long_string));
+  EXPECT_EQ(0U, heap_bytes(std::string("abc")));
+
+  auto strings = std::vector<std::string>{"abc", long_string};
+  EXPECT_EQ(strings.capacity() * sizeof(std::string) + heap_bytes(long_string),
+            heap_bytes(strings));
+
+  auto map = std::unordered_map<uint32_t, std::vector<uint32_t>>();
+  map[1].reserve(4);
+  EXPECT_GE(heap_bytes(map),
+            map.bucket_count() * sizeof(void*) + 4 * sizeof(uint32_t));
+
+  auto inner = memory_report();
+  inner.add("a", 10);
+  auto report = memory_report();
+  report.add("b", 5);
+  report.add("inner.", inner);
+  EXPECT_EQ(15U, report.total());
+  EXPECT_EQ("inner.a", report.components_[1].first);
+
+  auto out = std::stringstream();
+  report.write_json(out);
+  EXPECT_NE(std::string::npos, out.str().find("\"inner.a\": 10"));
+}
@@ -0,0 +1,275 @@
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "address-typeahead/extractor.h"
+#include "address-typeahead/merge.h"
+
+using namespace address_typeahead;
+
+// two regions sharing the country, a street along the border lies in the
+// country only and its house number 1 is contained in both extracts
+typeahead_context make_region(bool const west) {
+  typeahead_context c;
+  c.area_names_ = {"Land", west ? "Weststadt" : "Oststadt"};
+  c.areas_ = {area{0, ADMIN_LEVEL_2, west ? 1.6F : 1.75F},
+              area{1, ADMIN_LEVEL_8, west ? 1.4F : 1.25F},
+              area{28195, POSTCODE, 1.0F}};
+  c.area_osm_ids_ = {21, west ? 41 : 61, 81};
+  c.population_sum_ = west ? 100 : 80;
+
+  c.names_ = {"Grenzweg", west ? "Westplatz" : "Ostplatz"};
+  c.house_numbers_ = {"", west ? "1" : "2", west ? "2" : "1"};
+  c.places_ = {location{1, {west ? -10 : 10, 0}, {0, 1, 2}}};
+
+  street s;
+  s.name_idx_ = 0;
+  s.areas_ = {0};
+  s.house_numbers_ = {house_number{west ? 1U : 2U, {0, 1}}};
+  if (!west) {
+    s.house_numbers_.emplace_back(house_number{1, {0, 2}});
+  }
+  c.streets_ = {s};
+  return c;
+}
+
+TEST(Test, test_merge) {
+  auto const merged = merge({make_region(true), make_region(false)});
+
+  // areas ordered by osm id, names sorted
+  ASSERT_EQ(4U, merged.areas_.size());
+  EXPECT_EQ((std::vector<int64_t>{21, 41, 61, 81}), merged.area_osm_ids_);
+  EXPECT_EQ((std::vector<std::string>{"Land", "Oststadt", "Weststadt"}),
+            merged.area_names_);
+  EXPECT_EQ(2U, merged.areas_[1].name_idx_);
+  EXPECT_EQ(1U, merged.areas_[2].name_idx_);
+  EXPECT_EQ(28195U, merged.areas_[3].name_idx_);
+
+  // the population of the country is counted once
+  EXPECT_EQ((std::vector<uint64_t>{60, 40, 20, 0}), merged.area_population_);
+  EXPECT_EQ(120U, merged.population_sum_);
+  EXPECT_NEAR(1.5, merged.areas_[0].popularity_, 1e-4);
+  EXPECT_NEAR(1.0 + 40.0 / 120.0, merged.areas_[1].popularity_, 1e-4);
+  EXPECT_NEAR(1.0 + 20.0 / 120.0, merged.areas_[2].popularity_, 1e-4);
+
+  EXPECT_EQ((std::vector<std::string>{"Grenzweg", "Ostplatz", "Westplatz"}),
+            merged.names_);
+  ASSERT_EQ(2U, merged.places_.size());
+  EXPECT_EQ((std::vector<index_t>{0, 2, 3}), merged.places_[0].areas_);
+  EXPECT_EQ((std::vector<index_t>{0, 1, 3}), merged.places_[1].areas_);
+
+  ASSERT_EQ(1U, merged.streets_.size());
+  auto const& s = merged.streets_[0];
+  EXPECT_EQ(0U, s.name_idx_);
+  EXPECT_EQ((std::vector<index_t>{0}), s.areas_);
+  ASSERT_EQ(2U, s.house_numbers_.size());
+  EXPECT_EQ("1", merged.house_numbers_[s.house_numbers_[0].hn_idx_]);
+  EXPECT_EQ("2", merged.house_numbers_[s.house_numbers_[1].hn_idx_]);
+}
+
+TEST(Test, test_merge_aliases) {
+  auto west = make_region(true);
+  west.area_names_.emplace_back("Country");
+  west.area_aliases_ = {alias{0, 2}};
+  west.names_.emplace_back("Border Road");
+  west.names_.emplace_back("West Square");
+  west.aliases_ = {alias{0, 3}, alias{1, 2}};
+
+  auto east = make_region(false);
+  east.area_names_.emplace_back("Pays");
+  east.area_aliases_ = {alias{0, 2}};
+  east.names_.emplace_back("Border Road");
+  east.aliases_ = {alias{1, 2}};
+
+  auto const merged = merge({west, east});
+
+  auto const area_alias = [&](alias const& a) {
+    return std::make_pair(a.id_, merged.area_names_[a.name_idx_]);
+  };
+  ASSERT_EQ(2U, merged.area_aliases_.size());
+  EXPECT_EQ(std::make_pair(0U, std::string("Country")),
+            area_alias(merged.area_aliases_[0]));
+  EXPECT_EQ(std::make_pair(0U, std::string("Pays")),
+            area_alias(merged.area_aliases_[1]));
+
+  // places first: Ostplatz, Westplatz, then the street
+  ASSERT_EQ(2U, merged.places_.size());
+  EXPECT_EQ("Westplatz", merged.get_name(1));
+  EXPECT_EQ((std::vector<std::string>{"West Square"}), merged.get_aliases(1));
+  EXPECT_TRUE(merged.get_aliases(0).empty());
+  EXPECT_EQ("Grenzweg", merged.get_name(2));
+  EXPECT_EQ((std::vector<std::string>{"Border Road"}), merged.get_aliases(2));
+}
+
+void expect_same_context(typeahead_context const& a,
+                         typeahead_context const& b) {
+  EXPECT_EQ(a.names_, b.names_);
+  EXPECT_EQ(a.area_names_, b.area_names_);
+  EXPECT_EQ(a.house_numbers_, b.house_numbers_);
+  EXPECT_EQ(a.area_osm_ids_, b.area_osm_ids_);
+  EXPECT_EQ(a.area_population_, b.area_population_);
+  EXPECT_EQ(a.population_sum_, b.population_sum_);
+  EXPECT_EQ(a.name_keys_, b.name_keys_);
+  EXPECT_EQ(a.area_name_keys_, b.area_name_keys_);
+  EXPECT_EQ(a.importance_, b.importance_);
+  EXPECT_EQ(a.area_labels_, b.area_labels_);
+  EXPECT_EQ(a.label_areas_, b.label_areas_);
+
+  ASSERT_EQ(a.areas_.size(), b.areas_.size());
+  for (auto i = size_t(0); i != a.areas_.size(); ++i) {
+    EXPECT_EQ(a.areas_[i].name_idx_, b.areas_[i].name_idx_);
+    EXPECT_EQ(a.areas_[i].level_, b.areas_[i].level_);
+    EXPECT_EQ(a.areas_[i].popularity_, b.areas_[i].popularity_);
+  }
+  ASSERT_EQ(a.places_.size(), b.places_.size());
+  for (auto i = size_t(0); i != a.places_.size(); ++i) {
+    EXPECT_EQ(a.places_[i].name_idx_, b.places_[i].name_idx_);
+    EXPECT_EQ(a.places_[i].coordinates_.lon_, b.places_[i].coordinates_.lon_);
+    EXPECT_EQ(a.places_[i].coordinates_.lat_, b.places_[i].coordinates_.lat_);
+    EXPECT_EQ(a.places_[i].areas_, b.places_[i].areas_);
+  }
+  ASSERT_EQ(a.streets_.size(), b.streets_.size());
+  for (auto i = size_t(0); i != a.streets_.size(); ++i) {
+    auto const& sa = a.streets_[i];
+    auto const& sb = b.streets_[i];
+    EXPECT_EQ(sa.name_idx_, sb.name_idx_);
+    EXPECT_EQ(sa.areas_, sb.areas_);
+    ASSERT_EQ(sa.house_numbers_.size(), sb.house_numbers_.size());
+    for (auto j = size_t(0); j != sa.house_numbers_.size(); ++j) {
+      auto const& ha = sa.house_numbers_[j];
+      auto const& hb = sb.house_numbers_[j];
+      EXPECT_EQ(ha.hn_idx_, hb.hn_idx_);
+      EXPECT_EQ(ha.coordinates_.lon_, hb.coordinates_.lon_);
+      EXPECT_EQ(ha.coordinates_.lat_, hb.coordinates_.lat_);
+    }
+  }
+
+  auto const same_aliases = [](std::vector<alias> const& x,
+                               std::vector<alias> const& y) {
+    return std::equal(begin(x), end(x), begin(y), end(y),
+                      [](alias const& l, alias const& r) {
+                        return l.id_ == r.id_ && l.name_idx_ == r.name_idx_;
+                      });
+  };
+  EXPECT_TRUE(same_aliases(a.aliases_, b.aliases_));
+  EXPECT_TRUE(same_aliases(a.area_aliases_, b.area_aliases_));
+  EXPECT_EQ(a.interpolations_.size(), b.interpolations_.size());
+}
+
+TEST(Test, test_merge_order) {
+  expect_same_context(merge({make_region(true), make_region(false)}),
+                      merge({make_region(false), make_region(true)}));
+}
+
+std::string osm_node(int const id, double const lon, double const lat,
+                     std::string const& tags = "") {
+  return "<node id=\"" + std::to_string(id) + "\" version=\"1\" lat=\"" +
+         std::to_string(lat) + "\" lon=\"" + std::to_string(lon) + "\">" +
+         tags + "</node>\n";
+}
+
+std::string osm_tag(std::string const& key, std::string const& value) {
+  return "<tag k=\"" + key + "\" v=\"" + value + "\"/>";
+}
+
+// closed way around the nodes first_node .. first_node + 3
+std::string osm_boundary(int const id, int const first_node,
+                         std::string const& tags) {
+  auto way = "<way id=\"" + std::to_string(id) + "\" version=\"1\">";
+  for (auto const n : {0, 1, 2, 3, 0}) {
+    way += "<nd ref=\"" + std::to_string(first_node + n) + "\"/>";
+  }
+  return way + osm_tag("boundary", "administrative") + tags + "</way>\n";
+}
+
+void write_osm(std::string const& path,
+               std::vector<std::string> const& elements) {
+  std::ofstream out(path);
+  out << "<?xml version='1.0' encoding='UTF-8'?>\n"
+      << "<osm version=\"0.6\" generator=\"test\">\n";
+  for (auto const& e : elements) {
+    out << e;
+  }
+  out << "</osm>\n";
+}
+
+// a country with a west and an east town, a street between the towns has
+// house number 1 in both extracts
+TEST(Test, test_merge_extracts) {
+  auto const land = std::vector<std::string>{
+      osm_node(1, -1.0, 0.0), osm_node(2, 1.0, 0.0), osm_node(3, 1.0, 1.0),
+      osm_node(4, -1.0, 1.0)};
+  auto const west = std::vector<std::string>{
+      osm_node(5, -0.9, 0.1), osm_node(6, -0.1, 0.1), osm_node(7, -0.1, 0.9),
+      osm_node(8, -0.9, 0.9)};
+  auto const east = std::vector<std::string>{
+      osm_node(9, 0.1, 0.1), osm_node(10, 0.9, 0.1), osm_node(11, 0.9, 0.9),
+      osm_node(12, 0.1, 0.9)};
+  auto const westplatz = osm_node(
+      20, -0.5, 0.5,
+      osm_tag("name", "Westplatz") + osm_tag("name:en", "West Square") +
+          osm_tag("place", "square"));
+  auto const ostplatz = osm_node(
+      21, 0.5, 0.5, osm_tag("name", "Ostplatz") + osm_tag("place", "square"));
+  auto const address = [](int const id, double const lat,
+                          std::string const& house_number) {
+    return osm_node(id, 0.0, lat,
+                    osm_tag("addr:street", "Grenzweg") +
+                        osm_tag("addr:housenumber", house_number));
+  };
+  auto const land_way = osm_boundary(
+      100, 1,
+      osm_tag("admin_level", "2") + osm_tag("name", "Land") +
+          osm_tag("name:en", "Country") + osm_tag("population", "1000"));
+  auto const west_way =
+      osm_boundary(101, 5,
+                   osm_tag("admin_level", "8") + osm_tag("name", "Weststadt") +
+                       osm_tag("population", "300"));
+  auto const east_way =
+      osm_boundary(102, 9,
+                   osm_tag("admin_level", "8") + osm_tag("name", "Oststadt") +
+                       osm_tag("population", "200"));
+
+  auto const concat = [](std::vector<std::vector<std::string>> const& parts) {
+    auto result = std::vector<std::string>();
+    for (auto const& part : parts) {
+      result.insert(end(result), begin(part), end(part));
+    }
+    return result;
+  };
+  write_osm("test_merge_west.osm",
+            concat({land, west, {westplatz, address(30, 0.3, "1")},
+                    {land_way, west_way}}));
+  write_osm("test_merge_east.osm",
+            concat({land, east,
+                    {ostplatz, address(30, 0.3, "1"), address(31, 0.6, "2")},
+                    {land_way, east_way}}));
+  write_osm("test_merge_both.osm",
+            concat({land, west, east,
+                    {westplatz, ostplatz, address(30, 0.3, "1"),
+                     address(31, 0.6, "2")},
+                    {land_way, west_way, east_way}}));
+
+  auto options = extract_options();
+  options.whitelist_add("place");
+  options.whitelist_add("addr:housenumber");
+  auto const west_context = extract("test_merge_west.osm", options);
+  auto const east_context = extract("test_merge_east.osm", options);
+  auto const both = extract("test_merge_both.osm", options);
+  std::remove("test_merge_west.osm");
+  std::remove("test_merge_east.osm");
+  std::remove("test_merge_both.osm");
+
+  ASSERT_EQ(3U, both.areas_.size());
+  ASSERT_EQ(2U, both.places_.size());
+  ASSERT_EQ(1U, both.streets_.size());
+  EXPECT_EQ(2U, both.streets_[0].house_numbers_.size());
+  EXPECT_EQ(1500U, both.population_sum_);
+
+  expect_same_context(both, merge({west_context, east_context}));
+  expect_same_context(both, merge({east_context, west_context}));
+}
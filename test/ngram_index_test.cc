@@ -0,0 +1,108 @@
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <random>
+
+#include <gtest/gtest.h>
+
+#include "address-typeahead/ngram_index.h"
+
+using namespace address_typeahead;
+
+TEST(Test, test_ngram_trigrams) {
+  auto trigrams = std::vector<uint32_t>();
+  get_trigrams("AbA", trigrams);
+
+  // " ab", "aba", "ba "
+  auto const gram = [](char a, char b, char c) {
+    return (static_cast<uint32_t>(a) << 16U) |
+           (static_cast<uint32_t>(b) << 8U) | static_cast<uint32_t>(c);
+  };
+  EXPECT_EQ((std::vector<uint32_t>{gram(' ', 'a', 'b'), gram('a', 'b', 'a'),
+                                   gram('b', 'a', ' ')}),
+            trigrams);
+}
+
+TEST(Test, test_ngram_index_matches_exhaustive_search) {
+  auto rng = std::mt19937(7);
+  auto const letters = std::string("abcdefgh");
+  auto const random_string = [&](size_t const min_len) {
+    auto str = std::string();
+    auto const len = min_len + rng() % 8;
+    for (auto i = size_t(0); i != len; ++i) {
+      str.push_back(letters[rng() % letters.size()]);
+    }
+    return str;
+  };
+
+  // small and large indices are built differently, both have posting lists
+  // spanning many blocks
+  for (auto const num_strings : {3000, 70000}) {
+    auto strings = std::vector<std::pair<std::string, float>>();
+    for (auto i = 0; i != num_strings; ++i) {
+      strings.emplace_back(random_string(3), 1.0F + static_cast<float>(i % 5));
+    }
+    strings.emplace_back("", 1.0F);
+    strings.emplace_back("zero weight", 0.0F);
+    auto const index = ngram_index(strings);
+
+    auto query_grams = std::vector<uint32_t>();
+    auto candidate_grams = std::vector<uint32_t>();
+    for (auto q = 0; q != 20; ++q) {
+      auto const query = random_string(2);
+      get_trigrams(query, query_grams);
+
+      auto expected = std::vector<ngram_match>();
+      for (auto i = size_t(0); i != strings.size(); ++i) {
+        get_trigrams(strings[i].first, candidate_grams);
+        auto common = std::vector<uint32_t>();
+        std::set_intersection(begin(query_grams), end(query_grams),
+                              begin(candidate_grams), end(candidate_grams),
+                              std::back_inserter(common));
+        auto const norm = std::sqrt(static_cast<double>(
+            query_grams.size() * candidate_grams.size()));
+        auto const score = static_cast<float>(
+            static_cast<double>(common.size()) * strings[i].second / norm);
+        if (score > 0.0F) {
+          expected.push_back(ngram_match{static_cast<index_t>(i), score});
+        }
+      }
+      std::sort(begin(expected), end(expected),
+                [](ngram_match const& a, ngram_match const& b) {
+                  return a.cos_sim_ > b.cos_sim_ ||
+                         (a.cos_sim_ == b.cos_sim_ && a.index_ < b.index_);
+                });
+
+      auto const count = size_t(10);
+      auto const actual = index.match(query, count);
+      ASSERT_EQ(std::min(count, expected.size()), actual.size());
+      for (auto i = size_t(0); i != actual.size(); ++i) {
+        EXPECT_NEAR(expected[i].cos_sim_, actual[i].cos_sim_, 1e-5);
+      }
+    }
+  }
+}
+
+TEST(Test, test_ngram_scorer_matches_index) {
+  auto const strings = std::vector<std::pair<std::string, float>>{
+      {"gartenstrasse", 1.2F}, {"bremerhaven", 1.5F}, {"mitte-nord", 1.0F},
+      {"gartenweg", 1.2F},     {"bremen", 2.0F},      {"", 1.0F}};
+  auto const index = ngram_index(strings);
+  auto scorer = ngram_scorer(std::pmr::get_default_resource());
+  for (auto const& [str, weight] : strings) {
+    scorer.add(str, weight);
+  }
+
+  auto actual = std::pmr::vector<ngram_match>();
+  for (auto const query : {"garten", "bremen", "nord", "xyz"}) {
+    for (auto const count : {size_t(2), size_t(10)}) {
+      auto const expected = index.match(query, count);
+      scorer.match(query, count, actual);
+      ASSERT_EQ(expected.size(), actual.size());
+      for (auto i = size_t(0); i != actual.size(); ++i) {
+        EXPECT_EQ(expected[i].index_, actual[i].index_);
+        EXPECT_NEAR(expected[i].cos_sim_, actual[i].cos_sim_, 1e-5);
+      }
+    }
+  }
+}
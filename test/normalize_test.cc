@@ -0,0 +1,32 @@
+#include <gtest/gtest.h>
+
+#include "address-typeahead/normalize.h"
+
+using namespace address_typeahead;
+
+TEST(Test, test_normalize) {
+  EXPECT_EQ("gartenstrasse", normalize("Gartenstraße"));
+  EXPECT_EQ("gartenstrasse", normalize("Gartenstr."));
+  EXPECT_EQ("gartenstrasse", normalize("GARTENSTRASSE"));
+  EXPECT_EQ("muenchen", normalize("München"));
+  EXPECT_EQ("muenchen", normalize("Muenchen"));
+  EXPECT_EQ("cafe de paris", normalize("  Café   de\tParis "));
+  EXPECT_EQ("lodz", normalize("Łódź"));
+  EXPECT_EQ("platz der einheit", normalize("Pl. der Einheit"));
+  EXPECT_EQ("strandweg 2", normalize("Strandweg 2"));
+  EXPECT_EQ("apl.", normalize("Apl."));
+  EXPECT_EQ("москва", normalize("москва"));  // other scripts are kept
+  EXPECT_EQ("", normalize(" "));
+}
+
+TEST(Test, test_search_keys) {
+  typeahead_context context;
+  context.names_ = {"Hauptstr.", "Groß Ippener"};
+  context.area_names_ = {"Oldenburg (Oldb)"};
+  add_search_keys(context, 2);
+  ASSERT_EQ(2U, context.name_keys_.size());
+  EXPECT_EQ("hauptstrasse", context.name_keys_[0]);
+  EXPECT_EQ("gross ippener", context.name_keys_[1]);
+  ASSERT_EQ(1U, context.area_name_keys_.size());
+  EXPECT_EQ("oldenburg (oldb)", context.area_name_keys_[0]);
+}
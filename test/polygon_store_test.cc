@@ -0,0 +1,106 @@
+#include <gtest/gtest.h>
+
+#include "address-typeahead/polygon_store.h"
+
+using namespace address_typeahead;
+
+multi_polygon make_polygon(int32_t const x, int32_t const y) {
+  polygon pol;
+  bg::append(pol.outer(), point(x, y));
+  bg::append(pol.outer(), point(x, y + 1000));
+  bg::append(pol.outer(), point(x + 500, y + 1001));
+  bg::append(pol.outer(), point(x + 1000, y + 1000));
+  bg::append(pol.outer(), point(x + 1000, y));
+  bg::append(pol.outer(), point(x, y));
+
+  pol.inners().resize(1);
+  bg::append(pol.inners()[0], point(x + 400, y + 400));
+  bg::append(pol.inners()[0], point(x + 600, y + 400));
+  bg::append(pol.inners()[0], point(x + 600, y + 600));
+  bg::append(pol.inners()[0], point(x + 400, y + 400));
+
+  multi_polygon mp;
+  mp.push_back(pol);
+  return mp;
+}
+
+TEST(Test, test_polygon_store_round_trip) {
+  auto const a = make_polygon(-1800000000, -900000000);
+  auto const b = make_polygon(1799990000, 899990000);
+
+  polygon_store store;
+  EXPECT_EQ(0U, store.add(a));
+  EXPECT_EQ(1U, store.add(b));
+  EXPECT_EQ(2U, store.add(a));
+  EXPECT_EQ(3U, store.size());
+
+  // the rings of the third polygon are shared with the first one
+  EXPECT_EQ(4U, store.ring_offsets_.size() - 1);
+
+  for (auto const& [id, expected] :
+       std::vector<std::pair<index_t, multi_polygon>>{{0, a}, {1, b}, {2, a}}) {
+    auto const mp = store.get(id);
+    ASSERT_EQ(1U, mp.size());
+    EXPECT_TRUE(bg::equals(expected[0].outer(), mp[0].outer()));
+    ASSERT_EQ(1U, mp[0].inners().size());
+    EXPECT_TRUE(bg::equals(expected[0].inners()[0], mp[0].inners()[0]));
+  }
+}
+
+multi_polygon make_ring_polygon(std::vector<point> const& points) {
+  polygon pol;
+  for (auto const& p : points) {
+    bg::append(pol.outer(), p);
+  }
+  multi_polygon mp;
+  mp.push_back(pol);
+  return mp;
+}
+
+TEST(Test, test_simplify) {
+  polygon_store store;
+  store.add(make_polygon(0, 0));
+
+  // too small: simplification would degenerate the ring
+  store.add(make_ring_polygon({point(5000, 0), point(5005, 0), point(5000, 5),
+                               point(5000, 0)}));
+  store.simplify(10);
+
+  auto const mp = store.get(0);
+  EXPECT_EQ(5U, mp[0].outer().size());
+  EXPECT_EQ(4U, mp[0].inners()[0].size());
+  EXPECT_EQ(4U, store.get(1)[0].outer().size());
+}
+
+TEST(Test, test_simplify_shared_border) {
+  // two squares sharing a wiggly border
+  auto const left = make_ring_polygon(
+      {point(0, 0), point(1000, 0), point(1003, 250), point(998, 500),
+       point(1004, 750), point(1000, 1000), point(0, 1000), point(0, 0)});
+  auto const right = make_ring_polygon(
+      {point(1000, 0), point(2000, 0), point(2000, 1000), point(1000, 1000),
+       point(1004, 750), point(998, 500), point(1003, 250), point(1000, 0)});
+
+  polygon_store store;
+  store.add(left);
+  store.add(right);
+  store.simplify(10);
+
+  auto const a = store.get(0);
+  auto const b = store.get(1);
+  EXPECT_EQ(5U, a[0].outer().size());
+  EXPECT_EQ(5U, b[0].outer().size());
+
+  // no gaps or overlaps along the simplified border
+  multi_polygon overlap;
+  bg::intersection(a, b, overlap);
+  EXPECT_EQ(0.0, bg::area(overlap));
+  multi_polygon both;
+  bg::union_(a, b, both);
+  EXPECT_EQ(1U, both.size());
+  EXPECT_EQ(bg::area(a) + bg::area(b), bg::area(both));
+
+  box envelope;
+  ASSERT_TRUE(store.envelope(1, envelope));
+  EXPECT_TRUE(bg::equals(bg::return_envelope<box>(b), envelope));
+}
@@ -0,0 +1,61 @@
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "address-typeahead/prefix_index.h"
+
+using namespace address_typeahead;
+
+TEST(Test, test_prefix_index) {
+  auto const strings = std::vector<std::string>{
+      "bremen", "bremerhaven", "b", "berlin", "brake", "a", "brake"};
+  auto const scores =
+      std::vector<float>{3.0F, 2.0F, 1.0F, 5.0F, 1.0F, 1.0F, 4.0F};
+  auto const index = prefix_index(strings, scores);
+
+  EXPECT_EQ((std::vector<index_t>{3, 6, 0, 1}), index.match("b", 4));
+  EXPECT_EQ((std::vector<index_t>{6, 0, 1, 4}), index.match("br", 10));
+  EXPECT_EQ((std::vector<index_t>{0, 1}), index.match("brem", 10));
+  EXPECT_EQ((std::vector<index_t>{6, 4}), index.match("brake", 10));
+  EXPECT_EQ((std::vector<index_t>{5}), index.match("a", 10));
+  EXPECT_TRUE(index.match("c", 10).empty());
+  EXPECT_TRUE(index.match("bra", 0).empty());
+  EXPECT_TRUE(index.match("brakes", 10).empty());
+  EXPECT_TRUE(index.match("", 10).empty());
+}
+
+TEST(Test, test_prefix_index_matches_exhaustive_search) {
+  auto rng = std::mt19937(3);
+  auto strings = std::vector<std::string>();
+  auto scores = std::vector<float>();
+  for (auto i = 0; i != 5000; ++i) {
+    auto str = std::string();
+    for (auto j = rng() % 6; j != 0; --j) {
+      str.push_back(static_cast<char>('a' + rng() % 4));
+    }
+    strings.emplace_back(str);
+    scores.emplace_back(static_cast<float>(rng() % 100));
+  }
+  auto const index = prefix_index(strings, scores);
+
+  for (auto const& prefix : {"a", "cd", "abc", "dddd"}) {
+    for (auto const count : {size_t(5), size_t(40)}) {
+      auto expected = std::vector<index_t>();
+      for (auto i = index_t(0); i != strings.size(); ++i) {
+        if (strings[i].rfind(prefix, 0) == 0) {
+          expected.emplace_back(i);
+        }
+      }
+      std::sort(begin(expected), end(expected),
+                [&](index_t const a, index_t const b) {
+                  return scores[a] > scores[b] ||
+                         (scores[a] == scores[b] && a < b);
+                });
+      expected.resize(std::min(expected.size(), count));
+      EXPECT_EQ(expected, index.match(prefix, count)) << prefix;
+    }
+  }
+}
@@ -0,0 +1,49 @@
+#include <gtest/gtest.h>
+
+#include "address-typeahead/geometry.h"
+#include "address-typeahead/prepared_polygon.h"
+
+using namespace address_typeahead;
+
+multi_polygon square_with_hole() {
+  polygon pol;
+  bg::append(pol.outer(), point(0, 0));
+  bg::append(pol.outer(), point(0, 1000));
+  bg::append(pol.outer(), point(1000, 1000));
+  bg::append(pol.outer(), point(1000, 0));
+  bg::append(pol.outer(), point(0, 0));
+
+  pol.inners().resize(1);
+  bg::append(pol.inners()[0], point(400, 400));
+  bg::append(pol.inners()[0], point(600, 400));
+  bg::append(pol.inners()[0], point(600, 600));
+  bg::append(pol.inners()[0], point(400, 600));
+  bg::append(pol.inners()[0], point(400, 400));
+
+  multi_polygon mp;
+  mp.push_back(pol);
+  return mp;
+}
+
+TEST(Test, test_prepared_polygon_within) {
+  auto const mp = square_with_hole();
+  auto const prepared = prepared_polygon(mp);
+
+  for (int32_t x = -100; x <= 1100; x += 50) {
+    for (int32_t y = -100; y <= 1100; y += 50) {
+      auto const p = point(x, y);
+      EXPECT_EQ(bg::within(p, mp), prepared.within(p)) << x << ", " << y;
+    }
+  }
+}
+
+TEST(Test, test_prepared_polygon_boundary) {
+  auto const prepared = prepared_polygon(square_with_hole());
+
+  EXPECT_TRUE(prepared.within(point(100, 100)));
+  EXPECT_FALSE(prepared.within(point(500, 500)));
+  EXPECT_FALSE(prepared.within(point(0, 500)));
+  EXPECT_FALSE(prepared.within(point(400, 500)));
+  EXPECT_FALSE(prepared.within(point(2000, 500)));
+  EXPECT_FALSE(prepared_polygon().within(point(0, 0)));
+}
@@ -0,0 +1,41 @@
+#include <memory_resource>
+#include <string_view>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "address-typeahead/query_tokenizer.h"
+
+using namespace address_typeahead;
+
+TEST(Test, test_tokenize) {
+  auto tokens = std::pmr::vector<query_token>();
+  tokenize("  Gartenstraße 13a,27568 Bremerhaven;; . 123456789012 3x4 ",
+           tokens);
+
+  auto const expected = std::vector<std::pair<std::string_view, token_type>>{
+      {"Gartenstraße", token_type::WORD},
+      {"13a", token_type::HOUSE_NUMBER},
+      {",", token_type::SEPARATOR},
+      {"27568", token_type::POSTCODE},
+      {"Bremerhaven", token_type::WORD},
+      {";", token_type::SEPARATOR},
+      {".", token_type::HOUSE_NUMBER},
+      {"123456789012", token_type::WORD},
+      {"3x4", token_type::WORD}};
+  ASSERT_EQ(expected.size(), tokens.size());
+  for (auto i = size_t(0); i != tokens.size(); ++i) {
+    EXPECT_EQ(expected[i].first, tokens[i].str_);
+    EXPECT_EQ(expected[i].second, tokens[i].type_);
+  }
+  EXPECT_EQ(27568U, tokens[3].postcode_);
+
+  tokenize("12345 1234 B", tokens);
+  ASSERT_EQ(3U, tokens.size());
+  EXPECT_EQ(token_type::POSTCODE, tokens[0].type_);
+  EXPECT_EQ(token_type::HOUSE_NUMBER, tokens[1].type_);
+  EXPECT_EQ(token_type::WORD, tokens[2].type_);
+
+  tokenize(" \t ", tokens);
+  EXPECT_TRUE(tokens.empty());
+}
@@ -0,0 +1,49 @@
+#include <algorithm>
+#include <random>
+
+#include <gtest/gtest.h>
+
+#include "address-typeahead/score_kernels.h"
+
+using namespace address_typeahead;
+
+TEST(Test, test_score_kernels_match_scalar) {
+  auto rng = std::mt19937(3);
+  auto dist = std::uniform_real_distribution<float>(0.0F, 1.0F);
+
+  // sizes not divisible by the vector width exercise the scalar tails
+  for (auto const n : {size_t(0), size_t(5), size_t(1003)}) {
+    auto values = std::vector<float>(n);
+    auto acc = std::vector<float>(n);
+    for (auto i = size_t(0); i != n; ++i) {
+      values[i] = dist(rng);
+      acc[i] = dist(rng);
+    }
+
+    auto const& scalar = get_score_kernels(simd_level::SCALAR);
+    auto expected_selected = std::vector<uint32_t>();
+    scalar.select_geq_(values.data(), n, 0.5F, expected_selected);
+    auto expected_scaled = values;
+    scalar.scale_(expected_scaled.data(), n, 1.2F);
+    auto expected_acc = acc;
+    scalar.multiply_add_(expected_acc.data(), values.data(), n, 0.7F);
+
+    for (auto const level : {simd_level::SSE2, simd_level::AVX2}) {
+      auto const& kernels = get_score_kernels(level);
+
+      auto selected = std::vector<uint32_t>{42};
+      kernels.select_geq_(values.data(), n, 0.5F, selected);
+      ASSERT_EQ(expected_selected.size() + 1, selected.size());
+      EXPECT_TRUE(std::equal(begin(expected_selected), end(expected_selected),
+                             begin(selected) + 1));
+
+      auto scaled = values;
+      kernels.scale_(scaled.data(), n, 1.2F);
+      EXPECT_EQ(expected_scaled, scaled);
+
+      auto result_acc = acc;
+      kernels.multiply_add_(result_acc.data(), values.data(), n, 0.7F);
+      EXPECT_EQ(expected_acc, result_acc);
+    }
+  }
+}
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <fstream>
 #include <sstream>
 
@@ -7,6 +8,8 @@
 
 #include "address-typeahead/common.h"
 #include "address-typeahead/extractor.h"
+#include "address-typeahead/normalize.h"
+#include "address-typeahead/reverse_geocoder.h"
 #include "address-typeahead/serialization.h"
 #include "address-typeahead/typeahead.h"
 
@@ -22,7 +25,7 @@ public:
       cereal::BinaryInputArchive ia(in);
       ia(context_);
     }
-    typeahead_ = typeahead(context_);
+    typeahead_ = typeahead(context_, match_engine::GUESS);
   }
 
   typeahead_context context_;
@@ -60,7 +63,12 @@ TEST(Test, test_loading) {
   EXPECT_EQ(1728UL, context.streets_.size());
   EXPECT_EQ(17937UL, context.places_.size());
 
-  auto t = typeahead(context);
+  // the fixture is a snapshot in the original layout
+  EXPECT_TRUE(context.area_osm_ids_.empty());
+  EXPECT_TRUE(context.name_keys_.empty());
+  EXPECT_TRUE(context.importance_.empty());
+
+  auto t = typeahead(context, match_engine::GUESS);
   auto string_vec = std::vector<std::string>();
   string_vec.emplace_back("testce");
   auto candidates = t.complete(string_vec);
@@ -74,6 +82,47 @@ TEST(Test, test_loading) {
   EXPECT_EQ("Festma", context.get_name(candidates.at(1)));
 }
 
+TEST(Test, test_loading_baseline_format) {
+  // snapshot in the original layout without format header
+  auto const& c = test_env->context_;
+  std::stringstream ss;
+  {
+    cereal::BinaryOutputArchive oa(ss);
+    oa(c.places_, c.streets_, c.areas_, c.names_, c.area_names_,
+       c.house_numbers_);
+  }
+
+  typeahead_context context;
+  {
+    cereal::BinaryInputArchive ia(ss);
+    ia(context);
+  }
+  EXPECT_EQ(c.places_.size(), context.places_.size());
+  EXPECT_EQ(c.house_numbers_, context.house_numbers_);
+  EXPECT_TRUE(context.name_keys_.empty());
+  EXPECT_TRUE(context.importance_.empty());
+
+  // search keys and importance are computed by the typeahead
+  auto const t = typeahead(context, match_engine::GUESS);
+  auto string_vec = std::vector<std::string>();
+  string_vec.emplace_back("testc");
+  auto const result = t.complete(string_vec);
+  ASSERT_FALSE(result.empty());
+  EXPECT_EQ("Testcenter", context.get_name(result[0]));
+}
+
+TEST(Test, test_loading_newer_format) {
+  std::stringstream ss;
+  {
+    cereal::BinaryOutputArchive oa(ss);
+    oa(CONTEXT_FORMAT_MARKER, CONTEXT_FORMAT_VERSION + 1);
+  }
+
+  typeahead_context context;
+  cereal::BinaryInputArchive ia(ss);
+  EXPECT_THROW(ia(context), cereal::Exception);
+}
+
 TEST(Test, test_house_numbers) {
   auto string_vec = std::vector<std::string>();
   string_vec.emplace_back("gartenstr");
@@ -91,3 +140,179 @@ TEST(Test, test_house_numbers) {
   EXPECT_NEAR(53.5534, lat, 0.001);
   EXPECT_NEAR(8.57153, lon, 0.001);
 }
+
+TEST(Test, test_ngram_engine) {
+  auto const t = typeahead(test_env->context_, match_engine::NGRAM);
+
+  auto string_vec = std::vector<std::string>();
+  string_vec.emplace_back("testc");
+  auto const& result = t.complete(string_vec);
+  EXPECT_EQ("Testcenter", test_env->context_.get_name(result.at(0)));
+
+  string_vec[0] = "gartenstr";
+  string_vec.emplace_back("27568");
+  auto const& street = t.complete(string_vec);
+  auto const house_numbers = test_env->context_.get_house_numbers(street.at(0));
+  ASSERT_TRUE(!house_numbers.empty());
+  EXPECT_EQ("13", house_numbers[0]);
+}
+
+TEST(Test, test_short_prefix) {
+  auto string_vec = std::vector<std::string>();
+  string_vec.emplace_back("Te");
+  auto const& result = test_env->typeahead_.complete(string_vec);
+  ASSERT_FALSE(result.empty());
+  for (auto const& id : result) {
+    EXPECT_EQ("te", normalize(test_env->context_.get_name(id)).substr(0, 2));
+  }
+}
+
+TEST(Test, test_reverse_geocoding) {
+  auto const& context = test_env->context_;
+  auto const geocoder = reverse_geocoder(context);
+
+  auto const result = geocoder.lookup(53.5534, 8.57153, 3);
+  ASSERT_EQ(3U, result.size());
+  EXPECT_EQ("Gartenstraße", context.get_name(result[0].id_));
+  ASSERT_NE(NO_HOUSE_NUMBER, result[0].house_number_);
+  auto const& street =
+      context.streets_[result[0].id_ - context.places_.size()];
+  EXPECT_EQ("13", context.house_numbers_[street.house_numbers_
+                                             [result[0].house_number_]
+                                                 .hn_idx_]);
+  EXPECT_LT(result[0].distance_, 20.0);
+  EXPECT_LE(result[0].distance_, result[1].distance_);
+  EXPECT_LE(result[1].distance_, result[2].distance_);
+  auto const areas = context.get_area_names(result[0].id_);
+  EXPECT_TRUE(std::any_of(begin(areas), end(areas), [](auto const& a) {
+    return a.first == "Mitte-Nord";
+  }));
+}
+
+TEST(Test, test_complete_house_number) {
+  auto string_vec = std::vector<std::string>();
+  string_vec.emplace_back("gartenstr");
+  string_vec.emplace_back("27568");
+  auto const& t = test_env->typeahead_;
+  auto const street = t.complete(string_vec).at(0);
+
+  auto const house_numbers = t.complete_house_number(street, "1");
+  ASSERT_FALSE(house_numbers.empty());
+  for (auto const& hn : house_numbers) {
+    EXPECT_EQ('1', hn.house_number_[0]);
+  }
+  auto const thirteen = t.complete_house_number(street, "13", 1);
+  ASSERT_EQ(1U, thirteen.size());
+  EXPECT_EQ("13", thirteen[0].house_number_);
+  EXPECT_NEAR(53.5534, thirteen[0].coordinates_.lat_ / 10000000.0, 0.001);
+
+  EXPECT_TRUE(t.complete_house_number(0, "").empty());
+}
+
+TEST(Test, test_aliases) {
+  auto context = test_env->context_;
+  auto const testcenter = test_env->typeahead_.complete({"testcenter"}).at(0);
+  context.names_.emplace_back("Prüfzentrum Nord");
+  context.aliases_ = {
+      alias{testcenter, static_cast<index_t>(context.names_.size() - 1)}};
+  auto const t = typeahead(context, match_engine::GUESS);
+
+  auto const result = t.complete({"pruefzentrum"});
+  ASSERT_FALSE(result.empty());
+  EXPECT_EQ(testcenter, result[0]);
+  EXPECT_EQ("Testcenter", context.get_name(result[0]));
+  EXPECT_EQ((std::vector<std::string>{"Prüfzentrum Nord"}),
+            context.get_aliases(result[0]));
+}
+
+TEST(Test, test_complete_async) {
+  auto const strings = std::vector<std::string>{"gartenstr", "bremerhaven"};
+  auto const expected = test_env->typeahead_.complete(strings);
+
+  auto result =
+      test_env->typeahead_.complete_async(strings, complete_options()).get();
+  EXPECT_EQ(complete_status::COMPLETE, result.status_);
+  EXPECT_EQ(expected, result.ids_);
+
+  auto const token = std::make_shared<cancel_token>();
+  token->cancel();
+  result = test_env->typeahead_.complete_async(strings, complete_options(),
+                                               token).get();
+  EXPECT_EQ(complete_status::CANCELLED, result.status_);
+  EXPECT_TRUE(result.ids_.empty());
+
+  // guessing takes longer than the budget: no rerank
+  auto options = complete_options();
+  options.time_budget_ = std::chrono::microseconds(1);
+  result = test_env->typeahead_.complete(strings, options, nullptr);
+  EXPECT_EQ(complete_status::DEGRADED, result.status_);
+  ASSERT_FALSE(result.ids_.empty());
+  EXPECT_LE(result.ids_.size(), options.max_results_);
+}
+
+TEST(Test, test_raw_query) {
+  auto const& t = test_env->typeahead_;
+  auto const result = t.complete("gartenstr 13, 27568", complete_options());
+  EXPECT_EQ("13", result.house_number_);
+  EXPECT_EQ(t.complete({"gartenstr", "27568"}), result.ids_);
+
+  EXPECT_EQ(".", t.complete("gartenstr .", complete_options()).house_number_);
+
+  auto const only_house_number = t.complete("13", complete_options());
+  EXPECT_EQ("13", only_house_number.house_number_);
+  EXPECT_TRUE(only_house_number.ids_.empty());
+}
+
+TEST(Test, test_memory_usage) {
+  auto const report = test_env->typeahead_.memory_usage();
+  auto const context_report = test_env->typeahead_.context_.memory_usage();
+  EXPECT_GT(report.total(), context_report.total());
+
+  auto const bytes = [&](std::string const& name) {
+    for (auto const& [component, b] : report.components_) {
+      if (component == name) {
+        return b;
+      }
+    }
+    return uint64_t(0);
+  };
+  EXPECT_GT(bytes("context_.names_"), 0U);
+  EXPECT_GT(bytes("context_.places_.areas_"), 0U);
+  EXPECT_GT(bytes("place_guess_to_index_"), 0U);
+  EXPECT_GT(bytes("postcode_to_index_"), 0U);
+  EXPECT_GT(bytes("place_guesser_ (estimate)"), 0U);
+}
+
+TEST(Test, test_hot_tier) {
+  auto t = typeahead(test_env->context_, match_engine::NGRAM);
+  auto const query = std::vector<std::string>{"gartenstr", "27568"};
+  auto const full = t.complete(query, 1);
+  ASSERT_EQ(1U, full.size());
+
+  auto hot_options = hot_tier_options();
+  hot_options.size_ = 10;
+  hot_options.query_log_ = {full[0], full[0]};
+  t.build_hot_tier(hot_options);
+  auto const& hot_ids = t.hot_tier_->ids_;
+  ASSERT_EQ(10U, hot_ids.size());
+  EXPECT_NE(end(hot_ids), std::find(begin(hot_ids), end(hot_ids), full[0]));
+  EXPECT_EQ(10U, t.hot_tier_->typeahead_->context_.importance_.size());
+
+  EXPECT_EQ(full, t.complete(query, 1));
+  EXPECT_EQ(1U, t.get_tier_stats().hot_hits_);
+  EXPECT_EQ(0U, t.get_tier_stats().fallbacks_);
+
+  // not in the hot tier: answered by the full index
+  auto const result = t.complete({"testc"}, 1);
+  ASSERT_EQ(1U, result.size());
+  EXPECT_EQ("Testcenter", test_env->context_.get_name(result[0]));
+  EXPECT_EQ(end(hot_ids), std::find(begin(hot_ids), end(hot_ids), result[0]));
+  EXPECT_EQ(1U, t.get_tier_stats().fallbacks_);
+  EXPECT_DOUBLE_EQ(0.5, t.get_tier_stats().hit_rate());
+
+  auto options = complete_options();
+  options.max_results_ = 1;
+  options.use_hot_tier_ = false;
+  EXPECT_EQ(full, t.complete(query, options));
+  EXPECT_EQ(2U, t.get_tier_stats().hot_hits_ + t.get_tier_stats().fallbacks_);
+}